@@ -0,0 +1,119 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+
+// ----> Includes
+#include "aecagclog.hpp"
+
+#include <iostream>
+#include <fstream>
+#include <cstring>
+// <---- Includes
+
+// Convert the binary AEC/AGC registers log written by `VideoCapture::enableAecAgcSensLogging`
+// into a CSV file for each sensor: `<prefix>-LEFT.csv` and `<prefix>-RIGHT.csv`
+int main(int argc, char *argv[])
+{
+    if( argc<2 )
+    {
+        std::cerr << "Usage: " << argv[0] << " <log_file.bin> [output_prefix]" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::string in_path = argv[1];
+    std::string prefix = (argc>2)?argv[2]:in_path.substr(0, in_path.rfind(".bin"));
+
+    // ----> Header
+    std::ifstream in(in_path, std::ifstream::in | std::ifstream::binary);
+    if( !in.is_open() )
+    {
+        std::cerr << "Cannot open the log file: '" << in_path << "'" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    sl_oc::video::AecAgcLogHeader header;
+    if( !in.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+            memcmp(header.magic, AEC_AGC_LOG_MAGIC, sizeof(header.magic))!=0 )
+    {
+        std::cerr << "Not an AEC/AGC registers log file: '" << in_path << "'" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    if( header.version!=AEC_AGC_LOG_VERSION || header.reg_count!=AEC_AGC_LOG_REG_COUNT )
+    {
+        std::cerr << "Unsupported log file version: " << header.version << std::endl;
+        return EXIT_FAILURE;
+    }
+    // <---- Header
+
+    // ----> CSV files
+    const char* side_names[2] = {"LEFT", "RIGHT"};
+    std::ofstream out[2];
+    for( int side=0; side<2; side++ )
+    {
+        std::string out_path = prefix + "-" + side_names[side] + ".csv";
+        out[side].open(out_path, std::ofstream::out);
+        if( !out[side].is_open() )
+        {
+            std::cerr << "Cannot create the CSV file: '" << out_path << "'" << std::endl;
+            return EXIT_FAILURE;
+        }
+
+        out[side] << "TIMESTAMP";
+        for( int i=0; i<AEC_AGC_LOG_REG_COUNT; i++ )
+            out[side] << "," << sl_oc::video::getAecAgcLogRegisterName(i);
+        out[side] << "\n";
+    }
+    // <---- CSV files
+
+    // ----> Samples
+    uint64_t count = 0;
+    uint64_t errors = 0;
+    sl_oc::video::AecAgcLogSample sample;
+    char hex[8];
+    while( in.read(reinterpret_cast<char*>(&sample), sizeof(sample)) )
+    {
+        if( sample.side>1 )
+        {
+            std::cerr << "Corrupted sample at index " << count << std::endl;
+            return EXIT_FAILURE;
+        }
+
+        if( sample.result!=0 )
+            errors++;
+
+        std::ofstream& csv = out[sample.side];
+        csv << sample.frame_ts;
+        for( int i=0; i<AEC_AGC_LOG_REG_COUNT; i++ )
+        {
+            snprintf(hex, sizeof(hex), ",0x%02x", sample.values[i]);
+            csv << hex;
+        }
+        csv << "\n";
+
+        count++;
+    }
+    // <---- Samples
+
+    std::cout << "Converted " << count << " samples (" << errors << " with read errors) to '" << prefix << "-LEFT.csv' and '"
+              << prefix << "-RIGHT.csv'" << std::endl;
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,142 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+
+// ----> Includes
+#include "videocapture.hpp"
+
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <cmath>
+// <---- Includes
+
+// Duration of each test
+#define BENCH_DURATION_SEC 10
+
+// Print the statistics of the intervals between the received frames, compared to the nominal period
+void printJitter( const std::string& name, std::vector<uint64_t>& arrivals, double period_usec )
+{
+    if( arrivals.size()<3 )
+    {
+        std::cout << name << ": not enough frames" << std::endl;
+        return;
+    }
+
+    std::vector<double> jitter;
+    for( size_t i=1; i<arrivals.size(); i++ )
+    {
+        double dt_usec = static_cast<double>(arrivals[i]-arrivals[i-1])/1e3;
+        jitter.push_back(std::fabs(dt_usec-period_usec));
+    }
+
+    size_t n = jitter.size();
+    std::sort(jitter.begin(), jitter.end());
+
+    std::cout << name << std::endl;
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << " * Frames: " << arrivals.size() << " (expected " << BENCH_DURATION_SEC*1e6/period_usec << ")" << std::endl;
+    std::cout << " * Frame interval jitter p50: " << jitter[n/2] << " usec - p99: " << jitter[(n*99)/100]
+              << " usec - max: " << jitter[n-1] << " usec" << std::endl;
+}
+
+// Measure the frame arrival times, optionally changing the camera settings continuously from another thread
+void runTest( sl_oc::video::VideoCapture& cap, bool stress, double period_usec )
+{
+    std::vector<uint64_t> arrivals;
+    arrivals.reserve(BENCH_DURATION_SEC*100);
+    std::mutex arrivals_mutex;
+
+    // Inline callback: the arrival time is taken on the grabbing thread
+    int cb_id = cap.setFrameCallback([&](const sl_oc::video::FramePtr&){
+        uint64_t now = getSteadyTimestamp();
+        const std::lock_guard<std::mutex> lock(arrivals_mutex);
+        arrivals.push_back(now);
+    });
+
+    // ----> Control traffic
+    std::atomic<bool> stop{false};
+    uint64_t commands = 0;
+    std::thread ctrl_thread;
+    if( stress )
+    {
+        ctrl_thread = std::thread([&]{
+            int value = 0;
+            while( !stop )
+            {
+                cap.setExposure(sl_oc::video::CAM_SENS_POS::LEFT, 50+value);
+                cap.setGain(sl_oc::video::CAM_SENS_POS::LEFT, 50+value);
+                cap.getExposure(sl_oc::video::CAM_SENS_POS::RIGHT);
+                cap.getGain(sl_oc::video::CAM_SENS_POS::RIGHT);
+                value = (value+1)%10;
+                commands += 4;
+            }
+        });
+    }
+    // <---- Control traffic
+
+    std::this_thread::sleep_for(std::chrono::seconds(BENCH_DURATION_SEC));
+
+    stop = true;
+    if( ctrl_thread.joinable() )
+        ctrl_thread.join();
+    cap.removeFrameCallback(cb_id);
+
+    printJitter(stress?"Frames with control traffic":"Frames without control traffic", arrivals, period_usec);
+    if( stress )
+        std::cout << " * Settings commands: " << commands/BENCH_DURATION_SEC << " per second" << std::endl;
+
+    sl_oc::video::VideoStats stats = cap.getStats();
+    std::cout << " * Buffer queue mutex wait p99: " << stats.queue_mutex_wait.percentile(99)/1e3
+              << " usec - max: " << stats.queue_mutex_wait.max/1e3 << " usec" << std::endl;
+    std::cout << " * Control mutex hold p99: " << stats.com_mutex_hold.percentile(99)/1e3
+              << " usec - max: " << stats.com_mutex_hold.max/1e3 << " usec" << std::endl;
+}
+
+// The main function
+int main(int argc, char *argv[])
+{
+    // ----> Silence unused warning
+    (void)argc;
+    (void)argv;
+    // <---- Silence unused warning
+
+    sl_oc::video::VideoParams params;
+    params.res = sl_oc::video::RESOLUTION::HD720;
+    params.fps = sl_oc::video::FPS::FPS_60;
+
+    sl_oc::video::VideoCapture cap(params);
+    if( !cap.initializeVideo() )
+    {
+        std::cerr << "Cannot open camera video capture" << std::endl;
+        std::cerr << "See verbosity level for more details." << std::endl;
+
+        return EXIT_FAILURE;
+    }
+
+    double period_usec = 1e6/static_cast<double>(params.fps);
+
+    runTest(cap, false, period_usec);
+    runTest(cap, true, period_usec);
+
+    cap.resetAECAGC();
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,121 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+// ----> Includes
+#include "videocapture.hpp"
+
+#include <iostream>
+#include <iomanip>
+
+#include <time.h>
+// <---- Includes
+
+// Number of frames grabbed for each test
+#define BENCH_FRAME_COUNT 300
+
+// Process CPU time in nanoseconds, grabbing thread included
+uint64_t getProcessCpuTime()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return static_cast<uint64_t>(ts.tv_sec)*1000000000ULL + ts.tv_nsec;
+}
+
+// Grab `BENCH_FRAME_COUNT` frames using the copy or the zero-copy path and print the results
+bool runBenchmark( sl_oc::video::VideoParams params, bool zero_copy )
+{
+    params.zero_copy = zero_copy;
+
+    sl_oc::video::VideoCapture cap(params);
+    if( !cap.initializeVideo() )
+    {
+        std::cerr << "Cannot open camera video capture" << std::endl;
+        std::cerr << "See verbosity level for more details." << std::endl;
+
+        return false;
+    }
+
+    // Skip the first frames, the driver is still settling
+    for( int i=0; i<10; i++ )
+        cap.getLastFrame();
+
+    int frame_count = 0;
+    uint64_t last_id = 0;
+    uint64_t checksum = 0;
+
+    uint64_t start_cpu = getProcessCpuTime();
+    uint64_t start_ts = getSteadyTimestamp();
+
+    while( frame_count<BENCH_FRAME_COUNT )
+    {
+        if( zero_copy )
+        {
+            sl_oc::video::FrameLease lease = cap.leaseLastFrame();
+            if( !lease.valid() )
+                continue;
+
+            // Touch the frame so that the access cost is included
+            checksum += lease.frame().data[frame_count];
+        }
+        else
+        {
+            const sl_oc::video::Frame& frame = cap.getLastFrame();
+            if( frame.data==nullptr || frame.frame_id==last_id )
+                continue;
+            last_id = frame.frame_id;
+
+            checksum += frame.data[frame_count];
+        }
+
+        frame_count++;
+    }
+
+    double elapsed_sec = static_cast<double>(getSteadyTimestamp()-start_ts)/1e9;
+    double cpu_usec = static_cast<double>(getProcessCpuTime()-start_cpu)/1e3;
+
+    std::cout << (zero_copy?"Zero-copy (leaseLastFrame)":"Copy (getLastFrame)") << std::endl;
+    std::cout << " * Frames: " << frame_count << " - Freq: " << frame_count/elapsed_sec << " Hz" << std::endl;
+    std::cout << " * CPU time per frame: " << cpu_usec/frame_count << " usec" << std::endl;
+    std::cout << " * CPU load: " << 100.*cpu_usec/(elapsed_sec*1e6) << " %" << std::endl;
+    std::cout << " * Checksum: " << checksum << std::endl;
+
+    return true;
+}
+
+// The main function
+int main(int argc, char *argv[])
+{
+    // ----> Silence unused warning
+    (void)argc;
+    (void)argv;
+    // <---- Silence unused warning
+
+    sl_oc::video::VideoParams params;
+    params.res = sl_oc::video::RESOLUTION::HD2K;
+    params.fps = sl_oc::video::FPS::FPS_15;
+
+    if( !runBenchmark(params, false) )
+        return EXIT_FAILURE;
+
+    if( !runBenchmark(params, true) )
+        return EXIT_FAILURE;
+
+    return EXIT_SUCCESS;
+}
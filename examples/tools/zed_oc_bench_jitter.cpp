@@ -0,0 +1,204 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+// ----> Includes
+#include "videocapture.hpp"
+#ifdef SENSORS_MOD_AVAILABLE
+#include "sensorcapture.hpp"
+#endif
+
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <cmath>
+// <---- Includes
+
+// Duration of each test
+#define BENCH_DURATION_SEC 10
+
+// Real-time priority used for the capture threads
+#define BENCH_RT_PRIORITY 80
+
+// Busy threads competing with the capture threads for the CPUs
+class CpuLoad
+{
+public:
+    CpuLoad()
+    {
+        unsigned int n = std::max(1u, std::thread::hardware_concurrency());
+        for( unsigned int i=0; i<n; i++ )
+        {
+            mThreads.push_back(std::thread([this]{
+                volatile uint64_t count = 0;
+                while(!mStop) count = count+1;
+            }));
+        }
+    }
+
+    ~CpuLoad()
+    {
+        mStop = true;
+        for( std::thread& th : mThreads )
+            th.join();
+    }
+
+private:
+    std::atomic<bool> mStop{false};
+    std::vector<std::thread> mThreads;
+};
+
+// Print the statistics of the intervals between the received samples, compared to the nominal period
+void printJitter( const std::string& name, std::vector<uint64_t>& arrivals, double period_usec )
+{
+    if( arrivals.size()<3 )
+    {
+        std::cout << name << ": not enough samples" << std::endl;
+        return;
+    }
+
+    std::vector<double> jitter;
+    double sum = 0.0, sum2 = 0.0;
+    for( size_t i=1; i<arrivals.size(); i++ )
+    {
+        double dt_usec = static_cast<double>(arrivals[i]-arrivals[i-1])/1e3;
+        sum += dt_usec;
+        sum2 += dt_usec*dt_usec;
+        jitter.push_back(std::fabs(dt_usec-period_usec));
+    }
+
+    size_t n = jitter.size();
+    double mean = sum/n;
+    double stddev = std::sqrt(std::max(0.0,sum2/n-mean*mean));
+    std::sort(jitter.begin(), jitter.end());
+
+    std::cout << name << std::endl;
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << " * Samples: " << arrivals.size() << " - Mean interval: " << mean << " usec (nominal " << period_usec << " usec)" << std::endl;
+    std::cout << " * Interval std dev: " << stddev << " usec" << std::endl;
+    std::cout << " * Jitter p50: " << jitter[n/2] << " usec - p99: " << jitter[(n*99)/100] << " usec - max: " << jitter[n-1] << " usec" << std::endl;
+}
+
+// Measure the arrival time of the frames and of the IMU data with the given thread configuration
+bool runBenchmark( const sl_oc::ThreadConfig& cfg, const std::string& label )
+{
+    std::cout << std::endl << "***** " << label << " *****" << std::endl;
+
+    CpuLoad load;
+
+    // ----> Video
+    sl_oc::video::VideoParams params;
+    params.res = sl_oc::video::RESOLUTION::HD720;
+    params.fps = sl_oc::video::FPS::FPS_60;
+    params.grab_thread = cfg;
+    params.grab_thread.name = "zed_oc_video";
+
+    sl_oc::video::VideoCapture cap(params);
+    if( !cap.initializeVideo() )
+    {
+        std::cerr << "Cannot open camera video capture" << std::endl;
+        std::cerr << "See verbosity level for more details." << std::endl;
+
+        return false;
+    }
+
+    std::vector<uint64_t> frame_arrivals;
+    frame_arrivals.reserve(BENCH_DURATION_SEC*100);
+    std::mutex frame_mutex;
+
+    // Inline callback: the arrival time is taken on the grabbing thread
+    int cb_id = cap.setFrameCallback([&](const sl_oc::video::FramePtr&){
+        uint64_t now = getSteadyTimestamp();
+        const std::lock_guard<std::mutex> lock(frame_mutex);
+        frame_arrivals.push_back(now);
+    });
+    // <---- Video
+
+#ifdef SENSORS_MOD_AVAILABLE
+    // ----> Sensors
+    sl_oc::ThreadConfig sens_cfg = cfg;
+    sens_cfg.name = "zed_oc_sensors";
+
+    sl_oc::sensors::SensorCapture sens(sl_oc::VERBOSITY::ERROR, sens_cfg);
+    std::vector<int> devs = sens.getDeviceList();
+    bool sens_ok = !devs.empty() && sens.initializeSensors(devs[0]);
+
+    std::vector<uint64_t> imu_arrivals;
+    imu_arrivals.reserve(BENCH_DURATION_SEC*500);
+
+    if( sens_ok )
+    {
+        // The reading thread uses the same configuration
+        std::string err;
+        sl_oc::applyThreadConfig(cfg, err);
+    }
+    // <---- Sensors
+#endif
+
+    uint64_t end_ts = getSteadyTimestamp() + BENCH_DURATION_SEC*1000000000ULL;
+    while( getSteadyTimestamp()<end_ts )
+    {
+#ifdef SENSORS_MOD_AVAILABLE
+        if( sens_ok )
+        {
+            const sl_oc::sensors::data::Imu& imu = sens.getLastIMUData(5000);
+            if( imu.valid==sl_oc::sensors::data::Imu::NEW_VAL )
+                imu_arrivals.push_back(getSteadyTimestamp());
+            continue;
+        }
+#endif
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    cap.removeFrameCallback(cb_id);
+
+    printJitter("Video frames", frame_arrivals, 1e6/static_cast<double>(params.fps));
+#ifdef SENSORS_MOD_AVAILABLE
+    if( sens_ok )
+        printJitter("IMU data", imu_arrivals, 1e6/400.);
+#endif
+
+    sl_oc::video::FrameStats stats = cap.getFrameStats();
+    std::cout << " * Frames dropped by the driver: " << stats.dropped_driver << std::endl;
+
+    return true;
+}
+
+// The main function
+int main(int argc, char *argv[])
+{
+    // Optional argument: CPU affinity mask of the capture threads in the real-time test (e.g. `0x4`)
+    uint64_t cpu_mask = 0;
+    if( argc>1 )
+        cpu_mask = std::stoull(argv[1], nullptr, 0);
+
+    sl_oc::ThreadConfig def_cfg;
+    if( !runBenchmark(def_cfg, "Default scheduling") )
+        return EXIT_FAILURE;
+
+    sl_oc::ThreadConfig rt_cfg;
+    rt_cfg.policy = sl_oc::SCHED_POLICY::FIFO;
+    rt_cfg.priority = BENCH_RT_PRIORITY;
+    rt_cfg.cpu_mask = cpu_mask;
+    rt_cfg.lock_memory = true;
+    if( !runBenchmark(rt_cfg, "SCHED_FIFO priority " + std::to_string(BENCH_RT_PRIORITY)) )
+        return EXIT_FAILURE;
+
+    return EXIT_SUCCESS;
+}
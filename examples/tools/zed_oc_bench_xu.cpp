@@ -0,0 +1,223 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+
+// ----> Includes
+#include "videocapture.hpp"
+
+#include <linux/usb/video.h>  // for UVC_GET_LEN, UVC_SET_CUR, UVC_GET_CUR
+#include <linux/uvcvideo.h>   // for uvc_xu_control_query
+
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <algorithm>
+// <---- Includes
+
+// Number of commands sent for each test
+#define BENCH_CMD_COUNT 2000
+
+// Duration of a USB control transfer of the mock camera [usec]
+#define BENCH_TRANSFER_USEC 125
+
+// Length of the mock XU control (USB3) [bytes]
+#define BENCH_XU_LEN 384
+
+// Mock UVC extension unit: a command is executed in a random time after UVC_SET_CUR,
+// the requests received while it is executing are stalled (EPIPE)
+class MockXuDevice
+{
+public:
+    MockXuDevice( uint32_t exec_mean_usec, uint32_t exec_jitter_usec )
+        : mExecDist(static_cast<double>(exec_mean_usec), static_cast<double>(exec_jitter_usec)) {}
+
+    // UVCIOC_CTRL_QUERY request, used as transport of the XU commands of the library
+    int query( struct uvc_xu_control_query& q )
+    {
+        switch( q.query )
+        {
+        case UVC_GET_LEN:
+            return getLen(q.data);
+        case UVC_SET_CUR:
+            return setCur();
+        case UVC_GET_CUR:
+            return getCur();
+        default:
+            return EINVAL;
+        }
+    }
+
+    // UVC_GET_LEN
+    int getLen( uint8_t* data )
+    {
+        transfer();
+        data[0] = BENCH_XU_LEN & 0xff;
+        data[1] = (BENCH_XU_LEN >> 8) & 0xff;
+        return 0;
+    }
+
+    // UVC_SET_CUR: start a command
+    int setCur()
+    {
+        transfer();
+        if( busy() )
+            return EPIPE;
+
+        double exec = std::max(10.0, mExecDist(mGen));
+        mDoneTs = getSteadyTimestamp() + static_cast<uint64_t>(exec*1000.0);
+        mCommands++;
+        return 0;
+    }
+
+    // UVC_GET_CUR: read the result of the command
+    int getCur()
+    {
+        transfer();
+        return busy()?EPIPE:0;
+    }
+
+    // Check if the last command is completed, without a transfer: used to detect stale readings
+    bool busy() const {return getSteadyTimestamp()<mDoneTs;}
+
+    // Number of commands started
+    uint64_t commands() const {return mCommands;}
+
+private:
+    void transfer() {usleep(BENCH_TRANSFER_USEC);}
+
+    std::mt19937 mGen{42};
+    std::normal_distribution<double> mExecDist;
+    uint64_t mDoneTs = 0;
+    uint64_t mCommands = 0;
+};
+
+struct BenchResult
+{
+    std::vector<double> latency_usec;   // Latency of each XU command
+    int failures = 0;       // Commands whose result has not been read
+    int stale = 0;          // Results read before the command completion
+};
+
+// Reference: the command sequence of the library before the completion polling.
+// UVC_GET_LEN at each command and fixed delay after UVC_SET_CUR, no retry
+BenchResult runFixed( MockXuDevice& dev, bool read )
+{
+    BenchResult res;
+    uint8_t len[2];
+    for( int i=0; i<BENCH_CMD_COUNT; i++ )
+    {
+        uint64_t start = getSteadyTimestamp();
+
+        dev.getLen(len);
+        if( dev.setCur()!=0 )
+            res.failures++;
+        usleep(300);
+        if( read )
+        {
+            if( dev.busy() )
+                res.stale++;
+            if( dev.getCur()!=0 )
+                res.failures++;
+        }
+
+        res.latency_usec.push_back(static_cast<double>(getSteadyTimestamp()-start)/1e3);
+    }
+    return res;
+}
+
+// Library: XU commands sent by VideoCapture through the mock transport.
+// Write: LED status (GPIO direction and value commands). Read: sensor gain register burst read
+BenchResult runLibrary( MockXuDevice& dev, bool read )
+{
+    BenchResult res;
+
+    sl_oc::video::VideoCapture cap;
+    cap.setXuTransport([&dev]( struct uvc_xu_control_query& q ){return dev.query(q);});
+
+    for( int i=0; i<BENCH_CMD_COUNT; i++ )
+    {
+        uint64_t cmd_start = dev.commands();
+        uint64_t start = getSteadyTimestamp();
+
+        if( read )
+        {
+            if( cap.getGain(sl_oc::video::CAM_SENS_POS::LEFT)<0 )
+                res.failures++;
+        }
+        else
+        {
+            if( cap.setLEDstatus(i%2==0)!=0 )
+                res.failures++;
+        }
+
+        double elapsed = static_cast<double>(getSteadyTimestamp()-start)/1e3;
+        uint64_t cmds = std::max<uint64_t>(1, dev.commands()-cmd_start);
+        for( uint64_t c=0; c<cmds; c++ )
+            res.latency_usec.push_back(elapsed/cmds);
+    }
+
+    cap.setXuTransport(nullptr);
+    return res;
+}
+
+void printResult( const std::string& name, BenchResult& res )
+{
+    std::vector<double>& lat = res.latency_usec;
+    std::sort(lat.begin(), lat.end());
+    double sum = 0.0;
+    for( double l : lat ) sum += l;
+
+    size_t n = lat.size();
+    std::cout << std::left << std::setw(24) << name << std::right << std::fixed << std::setprecision(1)
+              << " mean " << std::setw(8) << sum/n << " usec"
+              << " - p50 " << std::setw(8) << lat[n/2]
+              << " - p99 " << std::setw(8) << lat[(n*99)/100]
+              << " - max " << std::setw(8) << lat[n-1]
+              << " - failures " << res.failures << " - stale " << res.stale << std::endl;
+}
+
+// The main function
+int main(int argc, char *argv[])
+{
+    // Optional arguments: mean and jitter of the mock command execution time [usec]
+    uint32_t exec_mean = 150;
+    uint32_t exec_jitter = 50;
+    if( argc>1 )
+        exec_mean = std::stoul(argv[1]);
+    if( argc>2 )
+        exec_jitter = std::stoul(argv[2]);
+
+    std::cout << "Mock XU command execution time: " << exec_mean << " +/- " << exec_jitter << " usec - "
+              << "transfer time: " << BENCH_TRANSFER_USEC << " usec - " << BENCH_CMD_COUNT << " commands" << std::endl;
+
+    MockXuDevice dev(exec_mean, exec_jitter);
+
+    BenchResult fixed_wr = runFixed(dev, false);
+    printResult("Fixed delay - write", fixed_wr);
+    BenchResult fixed_rd = runFixed(dev, true);
+    printResult("Fixed delay - read", fixed_rd);
+
+    BenchResult lib_wr = runLibrary(dev, false);
+    printResult("Library - write", lib_wr);
+    BenchResult lib_rd = runLibrary(dev, true);
+    printResult("Library - read", lib_rd);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,119 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+
+// ----> Includes
+#include "videocapture.hpp"
+#include "colorconv.hpp"
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <random>
+#include <algorithm>
+// <---- Includes
+
+// Duration of each measure
+#define BENCH_DURATION_MSEC 500
+
+// Average conversion time of a frame in microseconds
+double measure( const std::vector<uint8_t>& src, std::vector<uint8_t>& dst, int width, int height,
+                sl_oc::video::COLOR_FORMAT format, sl_oc::video::SIMD_LEVEL level )
+{
+    size_t dst_stride = static_cast<size_t>(width)*sl_oc::video::getColorFormatChannels(format);
+
+    uint64_t count = 0;
+    uint64_t start = getSteadyTimestamp();
+    uint64_t end = start + BENCH_DURATION_MSEC*1000000ULL;
+    uint64_t now = start;
+    do
+    {
+        sl_oc::video::convertYUYV(src.data(), width*2, dst.data(), dst_stride, width, height, format, level);
+        count++;
+        now = getSteadyTimestamp();
+    } while( now<end );
+
+    return static_cast<double>(now-start)/1e3/count;
+}
+
+// The main function
+int main(int argc, char *argv[])
+{
+    // ----> Silence unused warning
+    (void)argc;
+    (void)argv;
+    // <---- Silence unused warning
+
+    const char* res_names[] = {"HD2K", "HD1080", "HD720", "VGA"};
+    const char* fmt_names[] = {"BGR", "RGB", "BGRA", "RGBA"};
+    const char* level_names[] = {"AUTO", "SCALAR", "SSE2", "AVX2", "NEON"};
+
+    const sl_oc::video::SIMD_LEVEL levels[] = {sl_oc::video::SIMD_LEVEL::SSE2, sl_oc::video::SIMD_LEVEL::AVX2, sl_oc::video::SIMD_LEVEL::NEON};
+    const sl_oc::video::COLOR_FORMAT formats[] = {sl_oc::video::COLOR_FORMAT::BGR, sl_oc::video::COLOR_FORMAT::RGB,
+                                                  sl_oc::video::COLOR_FORMAT::BGRA, sl_oc::video::COLOR_FORMAT::RGBA};
+
+    std::cout << "Best instruction set: " << level_names[static_cast<int>(sl_oc::video::getBestSimdLevel())] << std::endl;
+
+    std::mt19937 rng(42);
+
+    for( int r=0; r<static_cast<int>(sl_oc::video::RESOLUTION::LAST); r++ )
+    {
+        // Side by side frame, as returned by the camera
+        int width = static_cast<int>(sl_oc::video::cameraResolution[r].width)*2;
+        int height = static_cast<int>(sl_oc::video::cameraResolution[r].height);
+
+        std::vector<uint8_t> src(static_cast<size_t>(width)*height*2);
+        std::generate(src.begin(), src.end(), [&rng]{return static_cast<uint8_t>(rng());});
+
+        std::cout << std::endl << "***** " << res_names[r] << " - " << width << "x" << height << " *****" << std::endl;
+
+        for( sl_oc::video::COLOR_FORMAT format : formats )
+        {
+            size_t dst_size = static_cast<size_t>(width)*height*sl_oc::video::getColorFormatChannels(format);
+            std::vector<uint8_t> ref(dst_size);
+            std::vector<uint8_t> dst(dst_size);
+
+            double ref_usec = measure(src, ref, width, height, format, sl_oc::video::SIMD_LEVEL::SCALAR);
+            std::cout << std::fixed << std::setprecision(1);
+            std::cout << " * " << fmt_names[static_cast<int>(format)] << " SCALAR: " << ref_usec << " usec" << std::endl;
+
+            for( sl_oc::video::SIMD_LEVEL level : levels )
+            {
+                if( !sl_oc::video::isSimdLevelSupported(level) )
+                    continue;
+
+                double usec = measure(src, dst, width, height, format, level);
+
+                size_t mismatch = 0;
+                for( size_t i=0; i<dst_size; i++ )
+                    mismatch += (dst[i]!=ref[i])?1:0;
+
+                std::cout << " * " << fmt_names[static_cast<int>(format)] << " " << level_names[static_cast<int>(level)] << ": "
+                          << usec << " usec - speedup x" << std::setprecision(2) << ref_usec/usec << std::setprecision(1)
+                          << " - " << (mismatch==0?"identical to the reference":"MISMATCH: ") ;
+                if( mismatch!=0 )
+                    std::cout << mismatch << " bytes";
+                std::cout << std::endl;
+            }
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
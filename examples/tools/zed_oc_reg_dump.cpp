@@ -0,0 +1,117 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+
+// ----> Includes
+#include "videocapture.hpp"
+
+#include <iostream>
+#include <iomanip>
+// <---- Includes
+
+// Maximum number of changed registers printed on the console
+#define MAX_PRINTED_CHANGES 200
+
+// Dump all the ISP and sensor registers of the first camera to a binary snapshot file.
+// If a previous snapshot is given, only the changed registers are saved and they are printed on the console.
+int main(int argc, char *argv[])
+{
+    if( argc<2 )
+    {
+        std::cerr << "Usage: " << argv[0] << " <snapshot.bin> [previous_snapshot.bin]" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::string out_path = argv[1];
+
+    // ----> Previous snapshot
+    sl_oc::video::RegisterSnapshot prev;
+    bool incremental = (argc>2);
+    if( incremental && !sl_oc::video::readRegisterSnapshot(argv[2], prev) )
+    {
+        std::cerr << "Cannot read the previous snapshot: '" << argv[2] << "'" << std::endl;
+        std::cerr << "The previous snapshot must be a complete snapshot." << std::endl;
+        return EXIT_FAILURE;
+    }
+    // <---- Previous snapshot
+
+    // ----> Create Video Capture
+    sl_oc::video::VideoParams params;
+    params.res = sl_oc::video::RESOLUTION::HD720;
+    params.fps = sl_oc::video::FPS::FPS_30;
+    params.verbose = sl_oc::VERBOSITY::ERROR;
+
+    sl_oc::video::VideoCapture cap(params);
+    if( !cap.initializeVideo() )
+    {
+        std::cerr << "Cannot open camera video capture" << std::endl;
+        std::cerr << "See verbosity level for more details." << std::endl;
+
+        return EXIT_FAILURE;
+    }
+    std::cout << "Connected to camera sn: " << cap.getSerialNumber() << std::endl;
+    // <---- Create Video Capture
+
+    // ----> Dump
+    sl_oc::video::RegisterSnapshot snap;
+    uint64_t start = getSteadyTimestamp();
+    int failures = cap.dumpRegisters(snap);
+    double elapsed_sec = static_cast<double>(getSteadyTimestamp()-start)/1e9;
+
+    std::cout << "Registers read in " << std::fixed << std::setprecision(2) << elapsed_sec << " sec";
+    if( failures>0 )
+        std::cout << " - " << failures << " registers cannot be read";
+    std::cout << std::endl;
+
+    if( !sl_oc::video::writeRegisterSnapshot(out_path, snap, incremental?&prev:nullptr) )
+    {
+        std::cerr << "Cannot write the snapshot: '" << out_path << "'" << std::endl;
+        return EXIT_FAILURE;
+    }
+    std::cout << "Snapshot saved: '" << out_path << "'" << std::endl;
+    // <---- Dump
+
+    // ----> Changes
+    if( incremental )
+    {
+        if( prev.serial_number!=snap.serial_number )
+            std::cout << "Warning: the previous snapshot has been taken on the camera sn: " << prev.serial_number << std::endl;
+
+        std::vector<sl_oc::video::RegisterChange> changes = sl_oc::video::diffRegisterSnapshots(prev, snap);
+        std::cout << changes.size() << " registers changed" << std::endl;
+
+        size_t printed = std::min<size_t>(changes.size(), MAX_PRINTED_CHANGES);
+        for( size_t i=0; i<printed; i++ )
+        {
+            const sl_oc::video::RegisterChange& chg = changes[i];
+            std::cout << (chg.bank==sl_oc::video::REG_BANK::ISP?"ISP   ":"SENSOR") << (chg.side==0?" L ":" R ")
+                      << "0x" << std::hex << std::setfill('0') << std::setw(8) << chg.address << " : ";
+            if( chg.old_value<0 ) std::cout << "--"; else std::cout << std::setw(2) << chg.old_value;
+            std::cout << " -> ";
+            if( chg.new_value<0 ) std::cout << "--"; else std::cout << std::setw(2) << chg.new_value;
+            std::cout << std::dec << std::endl;
+        }
+        if( printed<changes.size() )
+            std::cout << "..." << std::endl;
+    }
+    // <---- Changes
+
+    return EXIT_SUCCESS;
+}
@@ -38,13 +38,22 @@ int main(int argc, char *argv[])
     (void)argv;
     // <---- Silence unused warning
 
+    // ----> Find the connected cameras
+    std::vector<sl_oc::CameraDescriptor> cameras = sl_oc::discoverCameras();
+    if( cameras.size()<2 )
+    {
+        std::cerr << "This example requires two cameras, " << cameras.size() << " found" << std::endl;
+        return EXIT_FAILURE;
+    }
+    // <---- Find the connected cameras
+
     sl_oc::video::VideoParams params;
     params.res = sl_oc::video::RESOLUTION::HD720;
     params.fps = sl_oc::video::FPS::FPS_60;
 
     // ----> Create Video Capture 0
     sl_oc::video::VideoCapture cap_0(params);
-    if( !cap_0.initializeVideo(0) )
+    if( !cap_0.initializeVideo(cameras[0]) )
     {
         std::cerr << "Cannot open camera video capture" << std::endl;
         std::cerr << "See verbosity level for more details." << std::endl;
@@ -57,7 +66,7 @@ int main(int argc, char *argv[])
 
     // ----> Create Video Capture 1
     sl_oc::video::VideoCapture cap_1(params);
-    if( !cap_1.initializeVideo(2) )
+    if( !cap_1.initializeVideo(cameras[1]) )
     {
         std::cerr << "Cannot open camera video capture" << std::endl;
         std::cerr << "See verbosity level for more details." << std::endl;
@@ -20,6 +20,7 @@
 
 //// ----> Includes
 #include "videocapture.hpp"
+#include "colorconv.hpp"
 #include "ocv_display.hpp"
 
 #include <iostream>
@@ -92,9 +93,8 @@ int main(int argc, char *argv[])
 #endif
 
             // ----> Conversion from YUV 4:2:2 to BGR for visualization
-            cv::Mat frameYUV = cv::Mat( frame.height, frame.width, CV_8UC2, frame.data );
-            cv::Mat frameBGR;
-            cv::cvtColor(frameYUV,frameBGR,cv::COLOR_YUV2BGR_YUYV);
+            cv::Mat frameBGR( frame.height, frame.width, CV_8UC3 );
+            sl_oc::video::convertFrame( frame, frameBGR.data, frameBGR.step, sl_oc::video::COLOR_FORMAT::BGR );
             // <---- Conversion from YUV 4:2:2 to BGR for visualization
 
             // Show frame
@@ -0,0 +1,94 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+
+#ifndef AECAGCLOG_HPP
+#define AECAGCLOG_HPP
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+namespace sl_oc {
+
+namespace video {
+
+#define AEC_AGC_LOG_MAGIC       "ZEDOCAEL"  // First 8 bytes of the binary log file
+#define AEC_AGC_LOG_VERSION     1
+#define AEC_AGC_LOG_REG_COUNT   61          // Registers sampled for each sensor
+
+/*!
+ * \brief Header of the binary AEC/AGC registers log file, followed by the \ref AecAgcLogSample records
+ *
+ * All the values are stored in the byte order of the host that wrote the file.
+ */
+struct AecAgcLogHeader
+{
+    char magic[8];          //!< \ref AEC_AGC_LOG_MAGIC
+    uint32_t version;       //!< \ref AEC_AGC_LOG_VERSION
+    uint32_t reg_count;     //!< Number of registers of each sample
+};
+
+/*!
+ * \brief The AEC/AGC registers of a sensor, sampled after a frame
+ *
+ * Register order:
+ * - OV580 ISP registers `0x02`, `0x31`, `0x32`, `0x33`
+ * - OV580 luminance average registers `0xC0` to `0xE2`
+ * - OV4689 gain and exposure registers `0x3500` to `0x3515`
+ */
+struct AecAgcLogSample
+{
+    uint64_t frame_ts;      //!< Timestamp of the frame that triggered the sample
+    uint64_t sample_ts;     //!< Steady clock timestamp of the end of the registers reading [nsec]
+    int32_t result;         //!< `0` if all the registers have been read correctly
+    uint8_t side;           //!< Sensor position: `0` left, `1` right
+    uint8_t values[AEC_AGC_LOG_REG_COUNT]; //!< Register values
+    uint8_t reserved[6];
+};
+
+static_assert(sizeof(AecAgcLogHeader)==16, "Unexpected AecAgcLogHeader size");
+static_assert(sizeof(AecAgcLogSample)==88, "Unexpected AecAgcLogSample size");
+
+/*!
+ * \brief Get the name of a logged register, used as CSV column title
+ * \param idx the index of the register in \ref AecAgcLogSample::values
+ * \return the register name
+ */
+inline std::string getAecAgcLogRegisterName( int idx )
+{
+    static const char* isp_names[] = {"OV580-ISP_EN_HIGH", "OV580-yavg_low", "OV580-yavg_high", "OV580-interrupt_ctrl1"};
+
+    char name[32];
+    if( idx<4 )
+        return isp_names[idx];
+    else if( idx<4+0x23 )
+        snprintf(name, sizeof(name), "OV580-YAVG[0x%02x]", idx-4);
+    else
+        snprintf(name, sizeof(name), "OV4689-GAIN_EXP[0x%04x]", 0x3500+idx-4-0x23);
+
+    return name;
+}
+
+}
+
+}
+
+#endif // AECAGCLOG_HPP
@@ -0,0 +1,114 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+
+#ifndef COLORCONV_HPP
+#define COLORCONV_HPP
+
+#include "videocapture.hpp"
+
+#ifdef VIDEO_MOD_AVAILABLE
+
+namespace sl_oc {
+
+namespace video {
+
+/*!
+ * \brief Pixel format of the converted images
+ */
+enum class COLOR_FORMAT {
+    BGR,    //!< 3 bytes per pixel, OpenCV default order
+    RGB,    //!< 3 bytes per pixel
+    BGRA,   //!< 4 bytes per pixel, alpha set to 255
+    RGBA    //!< 4 bytes per pixel, alpha set to 255
+};
+
+/*!
+ * \brief Instruction set used by the color conversion kernels
+ */
+enum class SIMD_LEVEL {
+    AUTO,   //!< The best instruction set supported by the CPU
+    SCALAR, //!< Portable C++ reference implementation
+    SSE2,   //!< x86 SSE2
+    AVX2,   //!< x86 AVX2
+    NEON    //!< ARM NEON
+};
+
+/*!
+ * \brief Get the number of bytes per pixel of a color format
+ * \param format the color format
+ * \return the number of bytes per pixel
+ */
+inline int getColorFormatChannels( COLOR_FORMAT format )
+{
+    return (format==COLOR_FORMAT::BGRA || format==COLOR_FORMAT::RGBA)?4:3;
+}
+
+/*!
+ * \brief Get the best instruction set supported by the CPU, detected at the first call
+ * \return the instruction set used with \ref SIMD_LEVEL::AUTO
+ */
+SL_OC_EXPORT SIMD_LEVEL getBestSimdLevel();
+
+/*!
+ * \brief Check if an instruction set can be used on this CPU
+ * \param level the instruction set
+ * \return returns true if the conversion kernels of the instruction set are available
+ */
+SL_OC_EXPORT bool isSimdLevelSupported( SIMD_LEVEL level );
+
+/*!
+ * \brief Convert a YUV 4:2:2 (YUYV) image to BGR, RGB, BGRA or RGBA
+ * \param src the YUYV image
+ * \param src_stride the size of a row of the YUYV image in bytes
+ * \param dst the output buffer, allocated by the caller
+ * \param dst_stride the size of a row of the output buffer in bytes
+ * \param width the image width in pixels. It must be even
+ * \param height the image height in pixels
+ * \param format the output color format
+ * \param level the instruction set used for the conversion
+ * \return returns false if the parameters are not valid or the instruction set is not supported
+ *
+ * \note The conversion uses the BT.601 limited range coefficients, like `cv::COLOR_YUV2BGR_YUYV`, in fixed point
+ * arithmetic: all the instruction sets give the same result.
+ */
+SL_OC_EXPORT bool convertYUYV( const uint8_t* src, size_t src_stride, uint8_t* dst, size_t dst_stride,
+                               int width, int height, COLOR_FORMAT format, SIMD_LEVEL level=SIMD_LEVEL::AUTO );
+
+/*!
+ * \brief Convert a frame returned by \ref VideoCapture to BGR, RGB, BGRA or RGBA
+ * \param frame the frame
+ * \param dst the output buffer, allocated by the caller with `frame.height` rows
+ * \param dst_stride the size of a row of the output buffer in bytes, at least `frame.width` times the number of
+ *        bytes per pixel (see \ref getColorFormatChannels)
+ * \param format the output color format
+ * \param level the instruction set used for the conversion
+ * \return returns false if the frame is not valid
+ */
+SL_OC_EXPORT bool convertFrame( const Frame& frame, uint8_t* dst, size_t dst_stride,
+                                COLOR_FORMAT format, SIMD_LEVEL level=SIMD_LEVEL::AUTO );
+
+}
+
+}
+
+#endif // VIDEO_MOD_AVAILABLE
+
+#endif // COLORCONV_HPP
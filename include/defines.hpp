@@ -44,7 +44,7 @@
 
 //// SDK VERSION NUMBER
 #define ZED_OC_MAJOR_VERSION 0
-#define ZED_OC_MINOR_VERSION 6
+#define ZED_OC_MINOR_VERSION 7
 #define ZED_OC_PATCH_VERSION 0
 
 #define ZED_OC_VERSION_ATTRIBUTE private: uint32_t mMajorVer = ZED_OC_MAJOR_VERSION, mMinorVer = ZED_OC_MINOR_VERSION, mPatchVer = ZED_OC_PATCH_VERSION
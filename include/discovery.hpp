@@ -0,0 +1,75 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+
+#ifndef DISCOVERY_HPP
+#define DISCOVERY_HPP
+
+#include "defines.hpp"
+
+namespace sl_oc {
+
+/*!
+ * \brief The CameraDescriptor struct describes a Stereolabs camera found by \ref discoverCameras
+ */
+struct SL_OC_EXPORT CameraDescriptor
+{
+    int serial_number = -1;     //!< Camera serial number, read from the USB serial string. `-1` if not available
+    uint16_t video_pid = 0;     //!< USB Product ID of the video device
+    uint16_t fw_version = 0;    //!< Firmware version of the video device (`bcdDevice`)
+    int video_id = -1;          //!< Id of the video device (see `/dev/video*`)
+    std::string video_path;     //!< Path of the video device (e.g. `/dev/video0`)
+    std::string usb_path;       //!< USB port path of the video device (e.g. `1-2.1`)
+    int usb_bus = -1;           //!< USB bus number of the video device
+    int usb_dev = -1;           //!< USB device number of the video device. It changes each time the camera is plugged
+    uint16_t sensors_pid = 0;   //!< USB Product ID of the sensors device, `0` if the camera has no sensors
+    std::string hid_path;       //!< Path of the sensors HID device (e.g. `/dev/hidraw0`), empty if not available
+};
+
+/*!
+ * \brief Enumerate the Stereolabs cameras connected to the system
+ *
+ * The video devices are read from `/sys/class/video4linux` and matched by USB Vendor ID and Product ID, then
+ * correlated to the sensors HID devices through the shared USB parent. No device is opened, so the enumeration
+ * takes few milliseconds and does not interfere with cameras already in use.
+ *
+ * \return the list of the available cameras, sorted by video device id
+ */
+SL_OC_EXPORT std::vector<CameraDescriptor> discoverCameras();
+
+/*!
+ * \brief Get the USB information of a video device from sysfs, without opening it
+ * \param video_id the id of the video device (see `/dev/video*`)
+ * \param desc the descriptor of the camera. The sensors device is not searched
+ * \return returns false if the device is not a Stereolabs camera or sysfs is not available
+ */
+SL_OC_EXPORT bool describeVideoDevice( int video_id, CameraDescriptor& desc );
+
+/*!
+ * \brief Search a camera by serial number
+ * \param sn the serial number of the camera
+ * \param desc the descriptor of the camera, if found
+ * \return returns true if the camera is found
+ */
+SL_OC_EXPORT bool findCamera( int sn, CameraDescriptor& desc );
+
+}
+
+#endif // DISCOVERY_HPP
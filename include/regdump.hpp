@@ -0,0 +1,157 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+
+#ifndef REGDUMP_HPP
+#define REGDUMP_HPP
+
+#include "defines.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace sl_oc {
+
+namespace video {
+
+#define REG_DUMP_MAGIC              "ZEDOCREG"  // First 8 bytes of the binary register snapshot file
+#define REG_DUMP_VERSION            1
+
+#define REG_DUMP_ISP_ADDR_LEFT      0x80181000  // First OV580 ISP register of the left sensor
+#define REG_DUMP_ISP_ADDR_RIGHT     0x80181800  // First OV580 ISP register of the right sensor
+#define REG_DUMP_ISP_COUNT          0x800       // Number of OV580 ISP registers of each sensor
+#define REG_DUMP_SENS_ADDR          0x3000      // First OV4689 sensor control register
+#define REG_DUMP_SENS_COUNT         0x3001      // Number of OV4689 sensor control registers
+
+/*!
+ * \brief The register bank of a \ref RegisterBlock
+ */
+enum class REG_BANK : uint8_t {
+    ISP = 0,    //!< OV580 ISP system registers
+    SENSOR = 1  //!< OV4689 sensor control registers
+};
+
+/*!
+ * \brief A range of contiguous registers
+ */
+struct RegisterBlock
+{
+    REG_BANK bank = REG_BANK::ISP;  //!< Register bank
+    uint8_t side = 0;               //!< Sensor position: `0` left, `1` right
+    uint64_t address = 0;           //!< Address of the first register
+    std::vector<uint8_t> values;    //!< Register values
+    std::vector<uint8_t> valid;     //!< `1` if the register has been read correctly, `0` otherwise
+};
+
+/*!
+ * \brief Create an empty register range
+ * \param bank the register bank
+ * \param side the sensor position
+ * \param address the address of the first register
+ * \param count the number of registers
+ * \return the register range, with all the registers not valid
+ */
+inline RegisterBlock makeRegisterBlock( REG_BANK bank, uint8_t side, uint64_t address, size_t count )
+{
+    RegisterBlock block;
+    block.bank = bank;
+    block.side = side;
+    block.address = address;
+    block.values.resize(count, 0);
+    block.valid.resize(count, 0);
+    return block;
+}
+
+/*!
+ * \brief The values of all the camera registers at a given time
+ */
+struct RegisterSnapshot
+{
+    uint64_t timestamp = 0;             //!< Wall clock timestamp of the snapshot [nsec]
+    int32_t serial_number = -1;         //!< Serial number of the camera
+    std::vector<RegisterBlock> blocks;  //!< Register ranges
+
+    /*!
+     * \brief Find a register range
+     * \param bank the register bank
+     * \param side the sensor position
+     * \param address the address of the first register
+     * \return the register range, `nullptr` if not available
+     */
+    inline const RegisterBlock* findBlock( REG_BANK bank, uint8_t side, uint64_t address ) const
+    {
+        for( const RegisterBlock& block : blocks )
+        {
+            if( block.bank==bank && block.side==side && block.address==address )
+                return &block;
+        }
+        return nullptr;
+    }
+};
+
+/*!
+ * \brief A register whose value changed between two snapshots
+ */
+struct RegisterChange
+{
+    REG_BANK bank;          //!< Register bank
+    uint8_t side;           //!< Sensor position: `0` left, `1` right
+    uint64_t address;       //!< Register address
+    int old_value;          //!< Previous value, `-1` if not available
+    int new_value;          //!< Current value, `-1` if not available
+};
+
+/*!
+ * \brief Compare two register snapshots
+ * \param prev the previous snapshot
+ * \param cur the current snapshot
+ * \return the registers whose value or availability changed. Ranges missing in the previous snapshot are ignored
+ */
+SL_OC_EXPORT std::vector<RegisterChange> diffRegisterSnapshots( const RegisterSnapshot& prev, const RegisterSnapshot& cur );
+
+/*!
+ * \brief Write a register snapshot to a binary file
+ * \param path the path of the file
+ * \param snap the snapshot
+ * \param base optional previous snapshot: the ranges available in `base` are saved as the list of the changed
+ *        registers, and `base` is required to read the file
+ * \return returns false if the file cannot be written
+ *
+ * File layout: header (magic, version, timestamp, serial number, number of ranges), then for each range the bank,
+ * side, delta flag, number of registers, address and either all the values followed by the validity flags or
+ * the number of changes followed by the offset, value and validity flag of each changed register.
+ */
+SL_OC_EXPORT bool writeRegisterSnapshot( const std::string& path, const RegisterSnapshot& snap, const RegisterSnapshot* base=nullptr );
+
+/*!
+ * \brief Read a register snapshot from a binary file written by \ref writeRegisterSnapshot
+ * \param path the path of the file
+ * \param snap the snapshot
+ * \param base the snapshot used to write the file, required if the file contains only the changed registers
+ * \return returns false if the file cannot be read or if `base` is required
+ */
+SL_OC_EXPORT bool readRegisterSnapshot( const std::string& path, RegisterSnapshot& snap, const RegisterSnapshot* base=nullptr );
+
+}
+
+}
+
+#endif // REGDUMP_HPP
@@ -22,11 +22,14 @@
 #define SENSORCAPTURE_HPP
 
 #include "defines.hpp"
+#include "threadconfig.hpp"
+#include "stats.hpp"
 
 #include <thread>
 #include <vector>
 #include <map>
 #include <mutex>
+#include <atomic>
 
 #ifdef SENSORS_MOD_AVAILABLE
 
@@ -126,6 +129,22 @@ struct SL_OC_EXPORT Temperature
 
 }
 
+/*!
+ * \brief The SensorStats struct contains a snapshot of the internal metrics of a \ref SensorCapture
+ */
+struct SL_OC_EXPORT SensorStats
+{
+    double sample_rate = 0.0;       //!< Rate of the received sensor data [Hz]
+    uint64_t sample_count = 0;      //!< Number of received sensor data
+    uint64_t read_errors = 0;       //!< Number of failed or invalid HID reads
+
+    HistogramSnapshot hid_read_time;    //!< Duration of the HID reads returning sensor data [nsec]
+    HistogramSnapshot sample_interval;  //!< Host time interval between consecutive sensor data [nsec]
+
+    double ts_scaling = 1.0;        //!< Timestamp drift scaling factor applied to the MCU timestamps
+    int64_t sync_offset = 0;        //!< Timestamp offset respect to the synchronized camera [nsec]
+};
+
 /*!
  * \brief The SensorCapture class provides sensor grabbing functions for the Stereolabs ZED Mini and ZED2 camera models
  */
@@ -137,8 +156,9 @@ public:
     /*!
      * \brief The default constructor
      * \param verbose_lvl enable useful information to debug the class behaviours while running
+     * \param thread_cfg scheduling, affinity, name and memory locking of the sensor data grabbing thread
      */
-    SensorCapture( sl_oc::VERBOSITY verbose_lvl=sl_oc::VERBOSITY::ERROR );
+    SensorCapture( sl_oc::VERBOSITY verbose_lvl=sl_oc::VERBOSITY::ERROR, const ThreadConfig& thread_cfg=ThreadConfig() );
 
     /*!
      * \brief The class destructor
@@ -224,6 +244,32 @@ public:
      */
     static bool resetVideoModule(int serial_number=0);
 
+    /*!
+     * \brief Get a snapshot of the internal metrics: data rate, HID read timings and timestamp drift correction
+     * \return the current metrics, accumulated since the connection has been opened
+     */
+    SensorStats getStats();
+
+    /*!
+     * \brief Periodically write the metrics to a file in the Prometheus text format
+     * \param path the path of the file, e.g. in the directory of the node exporter textfile collector
+     * \param period_msec the writing period in milliseconds
+     *
+     * \note The file is written in a temporary file and then renamed, so it is never read partially
+     */
+    void startStatsDump(const std::string& path, uint32_t period_msec=1000);
+
+    /*!
+     * \brief Stop writing the metrics file
+     */
+    void stopStatsDump();
+
+    /*!
+     * \brief Get the metrics in the Prometheus text format
+     * \return the metrics text
+     */
+    std::string getStatsText();
+
 #ifdef VIDEO_MOD_AVAILABLE
     void updateTimestampOffset(uint64_t frame_ts);                                 //!< Called by  VideoCapture to update timestamp offset
     inline void setStartTimestamp(uint64_t start_ts){mStartSysTs=start_ts;}        //!< Called by  VideoCapture to sync timestamps reference point
@@ -251,6 +297,7 @@ private:
 private:
     // Flags
     int mVerbose=0;                //!< Verbose status
+    ThreadConfig mThreadCfg;            //!< Configuration of the grabbing thread
     bool mNewIMUData=false;             //!< Indicates if new  IMU data are available
     bool mNewMagData=false;             //!< Indicates if new  MAG data are available
     bool mNewEnvData=false;             //!< Indicates if new  ENV data are available
@@ -297,6 +344,17 @@ private:
     int64_t mSyncOffset=0;              //!< Timestamp offset respect to synchronized camera
     // <---- Timestamp synchronization
 
+    // ----> Metrics
+    Histogram mHidReadTime;             //!< Duration of the HID reads returning sensor data [nsec]
+    Histogram mSampleInterval;          //!< Host time interval between consecutive sensor data [nsec]
+    std::atomic<uint64_t> mSampleCount{0};  //!< Number of received sensor data
+    std::atomic<uint64_t> mReadErrors{0};   //!< Number of failed or invalid HID reads
+    std::atomic<uint64_t> mSampleIntervalAvg{0}; //!< Exponential moving average of the interval between sensor data [nsec]
+    std::atomic<double> mTsScalingStat{1.0};    //!< Copy of mNTPTsScaling readable by other threads
+    std::atomic<int64_t> mSyncOffsetStat{0};    //!< Copy of mSyncOffset readable by other threads
+    StatsDumper mStatsDumper;           //!< Writes the metrics file periodically
+    // <---- Metrics
+
 #ifdef VIDEO_MOD_AVAILABLE
     video::VideoCapture* mVideoPtr=nullptr;    //!< Pointer to the synchronized SensorCapture object
     uint64_t mSyncTs=0;                 //!< Timestamp of the latest received HW sync signal
@@ -0,0 +1,346 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+#ifndef STATS_HPP
+#define STATS_HPP
+
+#include "defines.hpp"
+
+#include <atomic>
+#include <array>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <functional>
+#include <sstream>
+#include <fstream>
+#include <cstdio>
+#include <algorithm>
+
+namespace sl_oc {
+
+#define HIST_SUB_BUCKETS_BITS   3                               // 8 sub-buckets for each power of two: max error 12.5%
+#define HIST_SUB_BUCKETS        (1<<HIST_SUB_BUCKETS_BITS)
+#define HIST_BUCKETS            ((64-HIST_SUB_BUCKETS_BITS+1)*HIST_SUB_BUCKETS)
+
+/*!
+ * \brief The HistogramSnapshot struct contains a copy of the values of a \ref Histogram
+ */
+struct SL_OC_EXPORT HistogramSnapshot
+{
+    uint64_t count = 0;     //!< Number of recorded values
+    uint64_t sum = 0;       //!< Sum of the recorded values
+    uint64_t max = 0;       //!< Maximum recorded value
+    std::array<uint64_t,HIST_BUCKETS> buckets{}; //!< Number of values recorded in each bucket
+
+    /*!
+     * \brief Get the mean of the recorded values
+     * \return the mean value, `0` if no value has been recorded
+     */
+    inline double mean() const {return count?static_cast<double>(sum)/count:0.0;}
+
+    /*!
+     * \brief Get a percentile of the recorded values
+     * \param p the percentile in the range [0,100]
+     * \return the upper bound of the bucket containing the percentile, `0` if no value has been recorded
+     */
+    inline uint64_t percentile( double p ) const
+    {
+        if( count==0 )
+            return 0;
+
+        uint64_t rank = static_cast<uint64_t>(p/100.0*count+0.5);
+        if( rank==0 ) rank = 1;
+        if( rank>count ) rank = count;
+
+        uint64_t seen = 0;
+        for( size_t i=0; i<buckets.size(); i++ )
+        {
+            seen += buckets[i];
+            if( seen>=rank )
+                return std::min(max, bucketUpperBound(i));
+        }
+        return max;
+    }
+
+    /*!
+     * \brief Get the highest value recorded in a bucket
+     * \param idx the index of the bucket
+     * \return the upper bound of the bucket
+     */
+    static inline uint64_t bucketUpperBound( size_t idx )
+    {
+        if( idx<HIST_SUB_BUCKETS )
+            return idx;
+
+        int msb = static_cast<int>(idx/HIST_SUB_BUCKETS) + HIST_SUB_BUCKETS_BITS - 1;
+        int shift = msb - HIST_SUB_BUCKETS_BITS;
+        uint64_t lower = (static_cast<uint64_t>(HIST_SUB_BUCKETS + idx%HIST_SUB_BUCKETS))<<shift;
+        return lower + ((1ULL<<shift)-1);
+    }
+};
+
+/*!
+ * \brief The Histogram class records values with a logarithmic resolution without locks
+ *
+ * Values are recorded by any number of threads with atomic increments; a snapshot can be taken at any time
+ * by any thread. The buckets have a relative width of 12.5%.
+ */
+class SL_OC_EXPORT Histogram
+{
+public:
+    Histogram() {reset();}
+
+    Histogram( const Histogram& ) = delete;
+    Histogram& operator=( const Histogram& ) = delete;
+
+    /*!
+     * \brief Record a value
+     * \param value the value to be recorded
+     */
+    inline void add( uint64_t value )
+    {
+        mBuckets[bucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+        mSum.fetch_add(value, std::memory_order_relaxed);
+        mCount.fetch_add(1, std::memory_order_relaxed);
+
+        uint64_t cur_max = mMax.load(std::memory_order_relaxed);
+        while( value>cur_max && !mMax.compare_exchange_weak(cur_max, value, std::memory_order_relaxed) ) {}
+    }
+
+    /*!
+     * \brief Get a copy of the recorded values
+     * \return the snapshot of the histogram. Values recorded while copying can be partially included.
+     */
+    inline HistogramSnapshot snapshot() const
+    {
+        HistogramSnapshot snap;
+        snap.count = 0;
+        for( size_t i=0; i<HIST_BUCKETS; i++ )
+        {
+            snap.buckets[i] = mBuckets[i].load(std::memory_order_relaxed);
+            snap.count += snap.buckets[i];
+        }
+        snap.sum = mSum.load(std::memory_order_relaxed);
+        snap.max = mMax.load(std::memory_order_relaxed);
+        return snap;
+    }
+
+    /*!
+     * \brief Clear all the recorded values
+     */
+    inline void reset()
+    {
+        for( size_t i=0; i<HIST_BUCKETS; i++ )
+            mBuckets[i].store(0, std::memory_order_relaxed);
+        mSum.store(0, std::memory_order_relaxed);
+        mCount.store(0, std::memory_order_relaxed);
+        mMax.store(0, std::memory_order_relaxed);
+    }
+
+private:
+    static inline size_t bucketIndex( uint64_t value )
+    {
+        if( value<HIST_SUB_BUCKETS )
+            return static_cast<size_t>(value);
+
+        int msb = 63 - __builtin_clzll(value);
+        int shift = msb - HIST_SUB_BUCKETS_BITS;
+        return static_cast<size_t>(msb-HIST_SUB_BUCKETS_BITS+1)*HIST_SUB_BUCKETS + ((value>>shift)&(HIST_SUB_BUCKETS-1));
+    }
+
+    std::array<std::atomic<uint64_t>,HIST_BUCKETS> mBuckets;  //!< Number of values recorded in each bucket
+    std::atomic<uint64_t> mSum{0};      //!< Sum of the recorded values
+    std::atomic<uint64_t> mCount{0};    //!< Number of recorded values
+    std::atomic<uint64_t> mMax{0};      //!< Maximum recorded value
+};
+
+/*!
+ * \brief The TimedLock class locks a mutex like `std::lock_guard`, recording the waiting and the holding times
+ */
+class TimedLock
+{
+public:
+    /*!
+     * \brief Lock the mutex, recording the time spent waiting for it
+     * \param mutex the mutex to be locked
+     * \param wait_hist histogram of the waiting times [nsec]
+     * \param hold_hist histogram of the holding times [nsec]
+     */
+    TimedLock( std::mutex& mutex, Histogram& wait_hist, Histogram& hold_hist ) : mMutex(mutex), mHoldHist(hold_hist)
+    {
+        uint64_t start = getSteadyTimestamp();
+        mMutex.lock();
+        mLockTs = getSteadyTimestamp();
+        wait_hist.add(mLockTs-start);
+    }
+
+    /*!
+     * \brief Unlock the mutex, recording the time it has been held
+     */
+    ~TimedLock()
+    {
+        mHoldHist.add(getSteadyTimestamp()-mLockTs);
+        mMutex.unlock();
+    }
+
+    TimedLock( const TimedLock& ) = delete;
+    TimedLock& operator=( const TimedLock& ) = delete;
+
+private:
+    std::mutex& mMutex;
+    Histogram& mHoldHist;
+    uint64_t mLockTs = 0;
+};
+
+/*!
+ * \brief Append a histogram to a Prometheus text exposition as a summary
+ * \param out the output stream
+ * \param name the metric name
+ * \param labels the metric labels, e.g. `device="/dev/video0"`
+ * \param snap the values of the histogram
+ * \param scale the factor applied to the values, e.g. `1e-9` to convert nanoseconds to seconds
+ * \param help the metric description
+ */
+inline void writePrometheusSummary( std::ostream& out, const std::string& name, const std::string& labels,
+                                    const HistogramSnapshot& snap, double scale, const std::string& help )
+{
+    out << "# HELP " << name << " " << help << "\n";
+    out << "# TYPE " << name << " summary\n";
+    const double quantiles[] = {0.5, 0.9, 0.99};
+    for( double q : quantiles )
+    {
+        out << name << "{" << labels << (labels.empty()?"":",") << "quantile=\"" << q << "\"} "
+            << static_cast<double>(snap.percentile(q*100.0))*scale << "\n";
+    }
+    out << name << "_sum{" << labels << "} " << static_cast<double>(snap.sum)*scale << "\n";
+    out << name << "_count{" << labels << "} " << snap.count << "\n";
+}
+
+/*!
+ * \brief Append a single value to a Prometheus text exposition
+ * \param out the output stream
+ * \param name the metric name
+ * \param type the metric type: `counter` or `gauge`
+ * \param labels the metric labels, e.g. `device="/dev/video0"`
+ * \param value the metric value
+ * \param help the metric description
+ */
+inline void writePrometheusValue( std::ostream& out, const std::string& name, const std::string& type,
+                                  const std::string& labels, double value, const std::string& help )
+{
+    out << "# HELP " << name << " " << help << "\n";
+    out << "# TYPE " << name << " " << type << "\n";
+    out << name << "{" << labels << "} " << value << "\n";
+}
+
+/*!
+ * \brief The StatsDumper class periodically writes a text file, e.g. for the Prometheus node exporter textfile collector
+ *
+ * The file is written to a temporary file and renamed, so that readers never see a partial file.
+ */
+class StatsDumper
+{
+public:
+    StatsDumper() = default;
+    ~StatsDumper() {stop();}
+
+    StatsDumper( const StatsDumper& ) = delete;
+    StatsDumper& operator=( const StatsDumper& ) = delete;
+
+    /*!
+     * \brief Start the writing thread, stopping the previous one
+     * \param path the path of the file
+     * \param period_msec the writing period in milliseconds
+     * \param format the function returning the content of the file
+     */
+    inline void start( const std::string& path, uint32_t period_msec, std::function<std::string()> format )
+    {
+        stop();
+
+        mPath = path;
+        mPeriodMsec = std::max(1u, period_msec);
+        mFormat = format;
+        mStop = false;
+        mThread = std::thread(&StatsDumper::run, this);
+    }
+
+    /*!
+     * \brief Stop the writing thread
+     */
+    inline void stop()
+    {
+        {
+            const std::lock_guard<std::mutex> lock(mMutex);
+            mStop = true;
+        }
+        mCv.notify_all();
+
+        if( mThread.joinable() )
+            mThread.join();
+    }
+
+    /*!
+     * \brief Write the file once
+     * \param path the path of the file
+     * \param content the content of the file
+     * \return returns false if the file cannot be written
+     */
+    static inline bool write( const std::string& path, const std::string& content )
+    {
+        std::string tmp_path = path + ".tmp";
+        {
+            std::ofstream file(tmp_path, std::ios::trunc);
+            if( !file.is_open() )
+                return false;
+            file << content;
+            if( !file.good() )
+                return false;
+        }
+        return std::rename(tmp_path.c_str(), path.c_str())==0;
+    }
+
+private:
+    inline void run()
+    {
+        std::unique_lock<std::mutex> lock(mMutex);
+        while( !mStop )
+        {
+            lock.unlock();
+            write(mPath, mFormat());
+            lock.lock();
+
+            mCv.wait_for(lock, std::chrono::milliseconds(mPeriodMsec), [this]{return mStop;});
+        }
+    }
+
+    std::thread mThread;
+    std::mutex mMutex;
+    std::condition_variable mCv;
+    bool mStop = true;
+
+    std::string mPath;
+    uint32_t mPeriodMsec = 1000;
+    std::function<std::string()> mFormat;
+};
+
+}
+
+#endif // STATS_HPP
@@ -0,0 +1,125 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+#ifndef THREADCONFIG_HPP
+#define THREADCONFIG_HPP
+
+#include "defines.hpp"
+
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <errno.h>
+#include <algorithm>
+
+namespace sl_oc {
+
+/*!
+ * \brief Scheduling policy of a capture thread
+ */
+enum class SCHED_POLICY {
+    OTHER,  //!< Default time-sharing scheduling
+    FIFO,   //!< Real-time first-in first-out scheduling (`SCHED_FIFO`)
+    RR      //!< Real-time round-robin scheduling (`SCHED_RR`)
+};
+
+/*!
+ * \brief The configuration applied to a capture thread when it starts
+ *
+ * \note Real-time scheduling and memory locking require the `CAP_SYS_NICE` and `CAP_IPC_LOCK` capabilities or
+ * suitable `rtprio` and `memlock` limits (see `/etc/security/limits.conf`). If a setting cannot be applied
+ * a warning is reported and the thread runs with the default value.
+ */
+struct SL_OC_EXPORT ThreadConfig
+{
+    SCHED_POLICY policy = SCHED_POLICY::OTHER; //!< Scheduling policy
+    int priority = 0;           //!< Real-time priority [1,99], used with \ref SCHED_POLICY::FIFO and \ref SCHED_POLICY::RR
+    uint64_t cpu_mask = 0;      //!< CPU affinity mask, bit `i` enables CPU `i`. `0` to not change the affinity
+    std::string name;           //!< Thread name (max 15 characters), empty to keep the default name
+    bool lock_memory = false;   //!< Lock the process memory, capture buffers included, with `mlockall` to avoid page faults
+};
+
+/*!
+ * \brief Apply a thread configuration to the calling thread
+ * \param cfg the configuration to be applied
+ * \param error_msg description of the settings that cannot be applied
+ * \return returns true if all the settings are applied
+ */
+inline bool applyThreadConfig( const ThreadConfig& cfg, std::string& error_msg )
+{
+    error_msg.clear();
+    pthread_t thread = pthread_self();
+
+    // ----> Thread name
+    if( !cfg.name.empty() )
+    {
+        std::string name = cfg.name.substr(0,15);
+        int ret = pthread_setname_np(thread, name.c_str());
+        if( ret!=0 )
+            error_msg += "Cannot set the thread name: " + std::string(strerror(ret)) + ". ";
+    }
+    // <---- Thread name
+
+    // ----> CPU affinity
+    if( cfg.cpu_mask!=0 )
+    {
+        cpu_set_t cpuset;
+        CPU_ZERO(&cpuset);
+        for( int cpu=0; cpu<64; cpu++ )
+        {
+            if( cfg.cpu_mask & (1ULL<<cpu) )
+                CPU_SET(cpu, &cpuset);
+        }
+
+        int ret = pthread_setaffinity_np(thread, sizeof(cpu_set_t), &cpuset);
+        if( ret!=0 )
+            error_msg += "Cannot set the CPU affinity: " + std::string(strerror(ret)) + ". ";
+    }
+    // <---- CPU affinity
+
+    // ----> Scheduling policy
+    if( cfg.policy!=SCHED_POLICY::OTHER )
+    {
+        int policy = (cfg.policy==SCHED_POLICY::FIFO)?SCHED_FIFO:SCHED_RR;
+
+        struct sched_param param;
+        memset(&param, 0, sizeof(param));
+        param.sched_priority = std::max(sched_get_priority_min(policy), std::min(sched_get_priority_max(policy), cfg.priority));
+
+        int ret = pthread_setschedparam(thread, policy, &param);
+        if( ret!=0 )
+            error_msg += "Cannot set the real-time scheduling: " + std::string(strerror(ret)) + ". ";
+    }
+    // <---- Scheduling policy
+
+    // ----> Memory locking
+    if( cfg.lock_memory )
+    {
+        if( mlockall(MCL_CURRENT|MCL_FUTURE)!=0 )
+            error_msg += "Cannot lock the memory: " + std::string(strerror(errno)) + ". ";
+    }
+    // <---- Memory locking
+
+    return error_msg.empty();
+}
+
+}
+
+#endif // THREADCONFIG_HPP
@@ -0,0 +1,98 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+#ifndef TRACE_HPP
+#define TRACE_HPP
+
+#include "defines.hpp"
+
+#ifdef TRACE_EVENTS_AVAILABLE
+
+namespace sl_oc {
+
+namespace trace {
+
+#define TRACE_DEFAULT_EVENTS_PER_THREAD 65536
+
+/*!
+ * \brief Start recording the trace events, discarding the events previously recorded
+ * \param events_per_thread size of the event buffer of each thread. The events recorded when the buffer is full are discarded
+ */
+SL_OC_EXPORT void start( size_t events_per_thread=TRACE_DEFAULT_EVENTS_PER_THREAD );
+
+/*!
+ * \brief Stop recording the trace events
+ */
+SL_OC_EXPORT void stop();
+
+/*!
+ * \brief Write the recorded events in the Chrome/Perfetto JSON trace format
+ * \param path the path of the JSON file, to be opened with `chrome://tracing` or https://ui.perfetto.dev
+ * \return returns false if the file cannot be written
+ */
+SL_OC_EXPORT bool write( const std::string& path );
+
+/*!
+ * \brief Record a trace event in the buffer of the calling thread, without locks
+ * \param name the event name. It must be a string literal
+ * \param phase the Chrome trace event phase: 'B' begin, 'E' end, 'i' instant
+ * \param arg a value associated to the event (e.g. the frame sequence number). It is signed, so that error codes
+ *        and negative offsets are reported correctly
+ */
+SL_OC_EXPORT void record( const char* name, char phase, int64_t arg );
+
+/*!
+ * \brief The Scope class records a begin event when created and an end event when destroyed
+ */
+class Scope
+{
+public:
+    Scope( const char* name, int64_t arg ) : mName(name) {record(mName,'B',arg);}
+    ~Scope() {record(mName,'E',0);}
+
+    Scope( const Scope& ) = delete;
+    Scope& operator=( const Scope& ) = delete;
+
+private:
+    const char* mName;
+};
+
+}
+
+}
+
+#define TRACE_CONCAT_IMPL(a,b) a##b
+#define TRACE_CONCAT(a,b) TRACE_CONCAT_IMPL(a,b)
+
+#define TRACE_INSTANT(name,arg) sl_oc::trace::record(name,'i',static_cast<int64_t>(arg))
+#define TRACE_BEGIN(name,arg) sl_oc::trace::record(name,'B',static_cast<int64_t>(arg))
+#define TRACE_END(name) sl_oc::trace::record(name,'E',0)
+#define TRACE_SCOPE(name,arg) sl_oc::trace::Scope TRACE_CONCAT(trace_scope_,__LINE__)(name,static_cast<int64_t>(arg))
+
+#else
+
+#define TRACE_INSTANT(name,arg)
+#define TRACE_BEGIN(name,arg)
+#define TRACE_END(name)
+#define TRACE_SCOPE(name,arg)
+
+#endif // TRACE_EVENTS_AVAILABLE
+
+#endif // TRACE_HPP
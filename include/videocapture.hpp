@@ -22,8 +22,20 @@
 #define VIDEOCAPTURE_HPP
 
 #include "defines.hpp"
+#include "stats.hpp"
+#include "discovery.hpp"
+#include "xupoll.hpp"
+#include "aecagclog.hpp"
+#include "regdump.hpp"
 #include <thread>
 #include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <atomic>
+#include <memory>
+#include <functional>
+#include <future>
 #include <fstream>      // std::ofstream
 #include <iomanip>
 
@@ -51,13 +63,231 @@ namespace video {
 struct SL_OC_EXPORT Frame
 {
     uint64_t frame_id = 0;          //!< Increasing index of frames
-    uint64_t timestamp = 0;         //!< Timestamp in nanoseconds
+    uint64_t timestamp = 0;         //!< Timestamp in nanoseconds, in the clock domain selected by \ref VideoParams::clock_domain
+    uint64_t raw_timestamp = 0;     //!< Timestamp assigned by the driver in nanoseconds (`CLOCK_MONOTONIC` for the UVC driver)
+    uint32_t sequence = 0;          //!< Sequence number assigned by the driver
     uint8_t* data = nullptr;        //!< Frame data in YUV 4:2:2 format
     uint16_t width = 0;             //!< Frame width
     uint16_t height = 0;            //!< Frame height
     uint8_t channels = 0;           //!< Number of channels per pixel
 };
 
+/*!
+ * \brief Shared handle on a frame: the frame data are valid as long as a handle refers to them
+ */
+typedef std::shared_ptr<const Frame> FramePtr;
+
+/*!
+ * \brief Function called for each new frame (see \ref VideoCapture::setFrameCallback)
+ */
+typedef std::function<void(const FramePtr&)> FrameCallback;
+
+/*!
+ * \brief The CallbackStats struct containing the execution statistics of a frame callback
+ */
+struct SL_OC_EXPORT CallbackStats
+{
+    uint64_t calls = 0;             //!< Number of completed calls
+    uint64_t skipped = 0;           //!< Frames skipped because the worker queue was full
+    uint64_t total_nsec = 0;        //!< Total execution time [nsec]
+    uint64_t min_nsec = 0;          //!< Minimum execution time [nsec]
+    uint64_t max_nsec = 0;          //!< Maximum execution time [nsec]
+    uint64_t last_nsec = 0;         //!< Execution time of the last call [nsec]
+};
+
+struct FrameCallbackSlot;
+
+/*!
+ * \brief Shadow state of a V4L2 camera control
+ */
+struct ControlShadow
+{
+    bool available = false;     //!< Indicates if the control is supported by the camera
+    int min = 0;                //!< Minimum value
+    int max = 0;                //!< Maximum value
+    int def = 0;                //!< Default value
+    int value = 0;              //!< Last value read or written
+    bool valid = false;         //!< Indicates if `value` matches the camera state
+    bool volatile_val = false;  //!< The value can be changed by the camera (`V4L2_CTRL_FLAG_VOLATILE`)
+};
+
+/*!
+ * \brief Shadow state of the camera settings written with XU commands, `-1` if unknown
+ */
+struct XuShadow
+{
+    int aec_agc = -1;               //!< Automatic exposure and gain control status
+    int gamma_preset[2] = {-1,-1};  //!< Gamma preset of each sensor
+    int gain[2] = {-1,-1};          //!< Gain of each sensor, unknown while AEC/AGC is active
+    int exposure[2] = {-1,-1};      //!< Exposure of each sensor, unknown while AEC/AGC is active
+    bool roi_valid[2] = {false,false}; //!< Indicates if `roi` matches the camera state
+    CameraRoi roi[2];               //!< AEC/AGC ROI of each sensor
+};
+
+struct ControlQueue;
+
+/*!
+ * \brief The FrameStats struct containing the counters of the discarded frames and the frame publishing latency
+ */
+struct SL_OC_EXPORT FrameStats
+{
+    uint64_t dropped_oldest = 0;    //!< Frames given back to the driver by \ref DROP_POLICY::DROP_OLDEST
+    uint64_t dropped_newest = 0;    //!< Frames given back to the driver by \ref DROP_POLICY::DROP_NEWEST
+    uint64_t dropped_driver = 0;    //!< Frames dropped by the driver because no buffer was available (e.g. \ref DROP_POLICY::BLOCK)
+    uint64_t dropped_pool = 0;      //!< Frames discarded because all the frame pool buffers were held by the application
+    uint64_t partial = 0;           //!< Incomplete frames received from the driver and discarded
+    uint64_t consumer_overwrite = 0;//!< Frames replaced by a newer frame before being retrieved with \ref VideoCapture::getLastFrame or \ref VideoCapture::acquireLastFrame
+
+    uint64_t publish_latency_p50 = 0; //!< Median latency between the frame dequeue and its publication [nsec]
+    uint64_t publish_latency_p90 = 0; //!< 90th percentile of the latency between the frame dequeue and its publication [nsec]
+    uint64_t publish_latency_p99 = 0; //!< 99th percentile of the latency between the frame dequeue and its publication [nsec]
+    uint64_t publish_latency_max = 0; //!< Maximum latency between the frame dequeue and its publication [nsec]
+};
+
+/*!
+ * \brief The VideoStats struct contains a snapshot of the internal metrics of a \ref VideoCapture
+ */
+struct SL_OC_EXPORT VideoStats
+{
+    double fps = 0.0;               //!< Frame rate measured on the received frames [Hz]
+    uint64_t frame_count = 0;       //!< Number of received frames
+    FrameStats frames;              //!< Counters of the discarded frames and publishing latency percentiles
+
+    HistogramSnapshot dqbuf_wait;       //!< Time waiting for a frame to be dequeued [nsec]
+    HistogramSnapshot memcpy_time;      //!< Time to copy a frame in the frame pool [nsec]
+    HistogramSnapshot publish_latency;  //!< Latency between the frame dequeue and its publication [nsec]
+    HistogramSnapshot com_mutex_wait;   //!< Time waiting for the UVC control communication mutex [nsec]
+    HistogramSnapshot com_mutex_hold;   //!< Time the UVC control communication mutex is held [nsec]
+    HistogramSnapshot queue_mutex_wait; //!< Time waiting for the UVC buffer queue mutex [nsec]
+    HistogramSnapshot queue_mutex_hold; //!< Time the UVC buffer queue mutex is held [nsec]
+
+    int driver_queue_depth = 0;     //!< Number of UVC buffers queued to the driver
+    int ready_queue_depth = 0;      //!< Number of dequeued UVC buffers waiting to be leased (zero-copy mode)
+    int callback_queue_depth = 0;   //!< Number of frames waiting for a frame callback worker
+};
+
+/*!
+ * \brief The ExportedFrame struct describes a frame shared with other processes as a DMABUF
+ *
+ * The DMABUF file descriptor can be sent to another process (e.g. with `SCM_RIGHTS` on a UNIX socket), that can
+ * `mmap` it or import it in a GPU/accelerator API to access the frame without copies.
+ */
+struct SL_OC_EXPORT ExportedFrame
+{
+    int dmabuf_fd = -1;             //!< DMABUF file descriptor of the UVC buffer containing the frame
+    size_t length = 0;              //!< Size of the DMABUF in bytes
+    uint32_t sequence = 0;          //!< Sequence number assigned by the driver, used to release the frame
+    uint64_t frame_id = 0;          //!< Increasing index of frames
+    uint64_t timestamp = 0;         //!< Timestamp in nanoseconds, in the clock domain selected by \ref VideoParams::clock_domain
+    uint64_t raw_timestamp = 0;     //!< Timestamp assigned by the driver in nanoseconds
+    uint16_t width = 0;             //!< Frame width
+    uint16_t height = 0;            //!< Frame height
+    uint8_t channels = 0;           //!< Number of channels per pixel
+};
+
+class VideoCapture;
+
+/*!
+ * \brief The FrameSubscriber class reads the frames published by a \ref VideoCapture with its own read cursor
+ *
+ * Each subscriber receives all the frames (\ref SUBSCRIBER_MODE::EVERY_FRAME) or the most recent one
+ * (\ref SUBSCRIBER_MODE::LATEST_ONLY), independently of the other subscribers and of \ref VideoCapture::getLastFrame.
+ * The grabbing thread never waits for the subscribers: a slow subscriber skips ahead to the oldest frame still available.
+ *
+ * \note A subscriber must be used by a single thread and must not outlive the \ref VideoCapture object that created it.
+ */
+class SL_OC_EXPORT FrameSubscriber
+{
+public:
+    /*!
+     * \brief The default constructor creates an invalid subscriber
+     */
+    FrameSubscriber() = default;
+
+    /*!
+     * \brief Indicates if the subscriber is connected to a camera
+     * \return true if the subscriber is valid
+     */
+    inline bool valid() const {return mCap!=nullptr;}
+
+    /*!
+     * \brief Get the next frame according to the subscriber mode
+     * \param timeout_msec frame waiting timeout in millisecond.
+     * \return returns a handle on the frame, `nullptr` if no new frame is received before the timeout
+     */
+    FramePtr next(uint64_t timeout_msec=100);
+
+    /*!
+     * \brief Get the number of frames skipped by the subscriber
+     * \return the number of published frames not returned by \ref next
+     */
+    inline uint64_t skipped() const {return mSkipped;}
+
+private:
+    friend class VideoCapture;
+
+    FrameSubscriber( VideoCapture* cap, SUBSCRIBER_MODE mode, uint64_t cursor ) : mCap(cap), mMode(mode), mCursor(cursor) {}
+
+    VideoCapture* mCap = nullptr;   //!< The VideoCapture object publishing the frames
+    SUBSCRIBER_MODE mMode = SUBSCRIBER_MODE::EVERY_FRAME; //!< The reading mode
+    uint64_t mCursor = 0;           //!< ID of the next frame to be read
+    uint64_t mSkipped = 0;          //!< Number of skipped frames
+};
+
+/*!
+ * \brief The FrameLease class gives direct access to a UVC buffer without copying its content.
+ *
+ * The leased buffer is given back to the driver only when the lease is released or destroyed,
+ * so the lease must be released as soon as the frame has been processed.
+ *
+ * \note A lease must not outlive the \ref VideoCapture object that created it.
+ */
+class SL_OC_EXPORT FrameLease
+{
+public:
+    /*!
+     * \brief The default constructor creates an empty lease
+     */
+    FrameLease() = default;
+
+    /*!
+     * \brief The class destructor releases the leased buffer
+     */
+    ~FrameLease(){release();}
+
+    FrameLease( const FrameLease& ) = delete;
+    FrameLease& operator=( const FrameLease& ) = delete;
+
+    FrameLease( FrameLease&& other );
+    FrameLease& operator=( FrameLease&& other );
+
+    /*!
+     * \brief Indicates if the lease refers to a valid frame
+     * \return true if the lease contains a valid frame
+     */
+    inline bool valid() const {return mCap!=nullptr;}
+
+    /*!
+     * \brief Get the leased frame
+     * \return returns a reference to the leased frame. Frame data point directly to the UVC buffer memory.
+     */
+    inline const Frame& frame() const {return mFrame;}
+
+    /*!
+     * \brief Give back the leased buffer to the driver. The lease is not valid anymore after this call.
+     */
+    void release();
+
+private:
+    friend class VideoCapture;
+
+    FrameLease( VideoCapture* cap, int index, const Frame& frame ) : mCap(cap), mIndex(index), mFrame(frame) {}
+
+    VideoCapture* mCap = nullptr;   //!< The VideoCapture object that owns the leased buffer
+    int mIndex = -1;                //!< The index of the leased UVC buffer
+    Frame mFrame;                   //!< The leased frame
+};
+
 /*!
  * \brief The VideoCapture class provides image grabbing functions and settings control for all the Stereolabs camera models
  */
@@ -84,6 +314,25 @@ public:
      */
     bool initializeVideo( int devId=-1 );
 
+    /*!
+     * \brief Open the ZED camera described by a descriptor returned by \ref discoverCameras or \ref findCamera
+     * \param desc the descriptor of the camera
+     * \return returns true if the camera is correctly opened. Returns false if the serial number or the USB port of
+     *         the opened device differs from the descriptor, e.g. if the camera has been plugged again after
+     *         the discovery and the video devices have been renumbered
+     *
+     * \note Use \ref findCamera to open a camera by serial number without probing all the video devices
+     */
+    bool initializeVideo( const CameraDescriptor& desc );
+
+    /*!
+     * \brief Open a ZED camera and apply a camera profile instead of the default settings
+     * \param profile the camera settings applied when the capture is started (see \ref applyProfile)
+     * \param devId Id of the camera (see `/dev/video*`). Use `-1` to open the first available camera
+     * \return returns true if the camera is correctly opened
+     */
+    bool initializeVideo( const CameraProfile& profile, int devId=-1 );
+
     /*!
      * \brief Get the last received camera image
      * \param timeout_msec frame grabbing timeout in millisecond.
@@ -94,9 +343,158 @@ public:
      *
      * \note Frame received will contains the RAW buffer from the camera, in YUV4:2:2 color format and in side by side mode.
      * Images must then be converted to RGB for proper display and will not be rectified.
+     *
+     * \note The returned frame is valid until the next call. Use \ref acquireLastFrame to keep a frame for a longer
+     * time or to get frames from more than one thread.
      */
     const Frame& getLastFrame(uint64_t timeout_msec=100);
 
+    /*!
+     * \brief Get a shared handle on the last received camera image
+     * \param timeout_msec frame grabbing timeout in millisecond.
+     * \return returns a handle on the last received frame, `nullptr` if no frame has been received yet.
+     *
+     * \note The frame content is never modified while the handle is alive: the grabbing thread fills a free buffer
+     * of the frame pool (see \ref VideoParams::frame_pool_size). If all the buffers are held by the application
+     * the new frames are discarded, so release the handles as soon as the frames have been processed.
+     *
+     * \note If \ref VideoParams::zero_copy is enabled the handle holds a \ref FrameLease on the UVC buffer.
+     */
+    FramePtr acquireLastFrame(uint64_t timeout_msec=100);
+
+    /*!
+     * \brief Create a frame subscriber with its own read cursor, starting from the next published frame
+     * \param mode the reading mode of the subscriber (see \ref SUBSCRIBER_MODE)
+     * \return returns the subscriber, not valid if \ref VideoParams::zero_copy is enabled
+     *
+     * \note Increase \ref VideoParams::frame_ring_size to let \ref SUBSCRIBER_MODE::EVERY_FRAME subscribers absorb
+     * processing time spikes without skipping frames.
+     */
+    FrameSubscriber subscribe(SUBSCRIBER_MODE mode=SUBSCRIBER_MODE::EVERY_FRAME);
+
+    /*!
+     * \brief Register a function to be called for each new frame
+     * \param callback the function to be called. The frame handle can be kept after the call
+     * \param mode the execution mode of the callback (see \ref CALLBACK_MODE)
+     * \param worker_count number of worker threads in \ref CALLBACK_MODE::WORKER_POOL mode
+     * \param queue_size maximum number of frames waiting for a worker in \ref CALLBACK_MODE::WORKER_POOL mode
+     * \return the ID of the callback, to be used with \ref removeFrameCallback and \ref getCallbackStats. `-1` on error
+     *
+     * \note The frames waiting in the queue and the frames being processed hold a frame pool buffer (or a UVC buffer in
+     * zero-copy mode): \ref VideoParams::frame_pool_size must be greater than `queue_size+worker_count` to not
+     * discard frames.
+     *
+     * \note The callbacks are removed when the camera is closed. A callback must not call \ref setFrameCallback or
+     * \ref removeFrameCallback.
+     */
+    int setFrameCallback(FrameCallback callback, CALLBACK_MODE mode=CALLBACK_MODE::INLINE, int worker_count=1, int queue_size=2);
+
+    /*!
+     * \brief Unregister a frame callback, waiting for the running calls to complete
+     * \param id the ID returned by \ref setFrameCallback
+     * \return returns false if the ID is not valid
+     */
+    bool removeFrameCallback(int id);
+
+    /*!
+     * \brief Get the execution statistics of a frame callback
+     * \param id the ID returned by \ref setFrameCallback
+     * \param stats the statistics of the callback
+     * \return returns false if the ID is not valid
+     */
+    bool getCallbackStats(int id, CallbackStats& stats);
+
+    /*!
+     * \brief Lease the last received camera image without copying it
+     * \param timeout_msec frame grabbing timeout in millisecond.
+     * \return returns a lease on the last received frame. The lease is not valid if no new frame is received
+     * before the timeout or if \ref VideoParams::zero_copy is not enabled.
+     *
+     * \note The leased UVC buffer is not available to the driver until the lease is released: keep the lease
+     * only for the time required to process the frame.
+     */
+    FrameLease leaseLastFrame(uint64_t timeout_msec=100);
+
+    /*!
+     * \brief Lease the oldest received camera image not yet leased, without copying it
+     * \param timeout_msec frame grabbing timeout in millisecond.
+     * \return returns a lease on the oldest available frame. The lease is not valid if no new frame is received
+     * before the timeout or if \ref VideoParams::zero_copy is not enabled.
+     *
+     * \note Use this function instead of \ref leaseLastFrame to process all the frames stored in the UVC buffers
+     * (see \ref VideoParams::buffer_count) after a processing delay.
+     */
+    FrameLease leaseNextFrame(uint64_t timeout_msec=100);
+
+    /*!
+     * \brief Export the last received camera image as a DMABUF to be shared with other processes
+     * \param frame the returned description of the exported frame
+     * \param timeout_msec frame grabbing timeout in millisecond.
+     * \return returns true if a new frame has been exported. Requires \ref VideoParams::zero_copy and
+     * \ref VideoParams::export_dmabuf to be enabled.
+     *
+     * \note The UVC buffer is not given back to the driver until \ref releaseExportedFrame is called with the
+     * sequence number of the frame, i.e. when all the remote consumers notified that they do not use it anymore.
+     */
+    bool exportLastFrame(ExportedFrame& frame, uint64_t timeout_msec=100);
+
+    /*!
+     * \brief Release a frame exported with \ref exportLastFrame
+     * \param sequence the sequence number of the exported frame
+     * \return returns true if the frame was exported and has been released
+     */
+    bool releaseExportedFrame(uint32_t sequence);
+
+    /*!
+     * \brief Release all the exported frames, e.g. when a remote consumer crashed without releasing its frames
+     */
+    void releaseAllExportedFrames();
+
+    /*!
+     * \brief Get a file descriptor that becomes readable each time a new frame is available
+     * \return the file descriptor of an `eventfd` object, -1 if it is not available
+     *
+     * \note The file descriptor can be added to an application `poll`/`epoll` loop. Read its 8 bytes counter
+     * to clear the event, then get the frame with \ref getLastFrame or \ref leaseLastFrame.
+     *
+     * \note The file descriptor is owned by the VideoCapture object: do not close it.
+     */
+    inline int getFrameEventFd(){return mFrameEventFd;}
+
+    /*!
+     * \brief Get the counters of the discarded frames and the frame publishing latency percentiles
+     * \return the current frame counters, accumulated since the camera has been opened
+     *
+     * \note The counters only increase: they can be polled periodically to raise alarms on their increments.
+     */
+    FrameStats getFrameStats();
+
+    /*!
+     * \brief Get a snapshot of the internal metrics: frame rate, timings, mutex contention and queue depths
+     * \return the current metrics, accumulated since the camera has been opened
+     */
+    VideoStats getStats();
+
+    /*!
+     * \brief Periodically write the metrics to a file in the Prometheus text format
+     * \param path the path of the file, e.g. in the directory of the node exporter textfile collector
+     * \param period_msec the writing period in milliseconds
+     *
+     * \note The file is written in a temporary file and then renamed, so it is never read partially
+     */
+    void startStatsDump(const std::string& path, uint32_t period_msec=1000);
+
+    /*!
+     * \brief Stop writing the metrics file
+     */
+    void stopStatsDump();
+
+    /*!
+     * \brief Get the metrics in the Prometheus text format
+     * \return the metrics text
+     */
+    std::string getStatsText();
+
     /*!
      * \brief Get the size of the camera frame
      * \param width the frame width
@@ -276,6 +674,16 @@ public:
      */
     void resetAECAGC();
 
+    /*!
+     * \brief Apply all the camera settings of a profile
+     *
+     * Only the settings that differ from the known camera state are sent: the V4L2 controls are written with a single
+     * `VIDIOC_S_EXT_CTRLS` request, the XU registers with one burst command for each setting.
+     * \param profile the camera settings
+     * \return returns true if all the settings have been applied
+     */
+    bool applyProfile(const CameraProfile& profile);
+
     /*!
      * \brief Set Region Of Interest (ROI) for AECAGC control
      * \param side position of the camera sensor (see  CAM_SENS_POS)
@@ -334,12 +742,50 @@ public:
     int getExposure(CAM_SENS_POS cam);
     // <---- Camera Settings control
 
+    // ----> Asynchronous Camera Settings control
+    /*!
+     * \name Asynchronous camera settings control
+     *
+     * The commands are executed in order by a dedicated thread, so the calling thread never waits for the USB control
+     * transfers. A command replaces the pending command of the same setting (e.g. the gain of the same sensor):
+     * only the latest value is sent to the camera and it is moved to the end of the queue. The returned future
+     * is set to `true` when the command has been executed, or when it has been replaced by a newer command
+     * that has been executed, and to `false` if the camera is closed before the execution or if the command failed:
+     * the value is out of the range of the V4L2 control (brightness, sharpness, contrast, hue, saturation,
+     * white balance, gamma) or the V4L2 control or XU register write returned an error. Gain and exposure
+     * values out of range are clamped as in the synchronous functions.
+     */
+    ///@{
+    std::future<bool> setLEDstatusAsync(bool status);                   //!< Asynchronous \ref setLEDstatus
+    std::future<bool> setBrightnessAsync(int brightness);               //!< Asynchronous \ref setBrightness
+    std::future<bool> setSharpnessAsync(int sharpness);                 //!< Asynchronous \ref setSharpness
+    std::future<bool> setContrastAsync(int contrast);                   //!< Asynchronous \ref setContrast
+    std::future<bool> setHueAsync(int hue);                             //!< Asynchronous \ref setHue
+    std::future<bool> setSaturationAsync(int saturation);               //!< Asynchronous \ref setSaturation
+    std::future<bool> setWhiteBalanceAsync(int wb);                     //!< Asynchronous \ref setWhiteBalance
+    std::future<bool> setAutoWhiteBalanceAsync(bool active);            //!< Asynchronous \ref setAutoWhiteBalance
+    std::future<bool> setGammaAsync(int gamma);                         //!< Asynchronous \ref setGamma
+    std::future<bool> setAECAGCAsync(bool active);                      //!< Asynchronous \ref setAECAGC
+    std::future<bool> setROIforAECAGCAsync(CAM_SENS_POS side, uint16_t x, uint16_t y, uint16_t w, uint16_t h); //!< Asynchronous \ref setROIforAECAGC
+    std::future<bool> setGainAsync(CAM_SENS_POS cam, int gain);         //!< Asynchronous \ref setGain
+    std::future<bool> setExposureAsync(CAM_SENS_POS cam, int exposure); //!< Asynchronous \ref setExposure
+    ///@}
+    // <---- Asynchronous Camera Settings control
+
     /*!
      * \brief Retrieve the serial number of the connected camera
      * \return the serial number of the connected camera
+     *
+     * \note The serial number is read when the camera is opened, this function does not access the device
      */
     int getSerialNumber();
 
+    /*!
+     * \brief Retrieve the identity of the connected camera: serial number, model, firmware version and USB port
+     * \return the identity read when the camera has been opened
+     */
+    inline const CameraIdentity& getCameraIdentity() const {return mIdentity;}
+
     /*!
      * \brief Utils fct to set Color Bars on Image
      */
@@ -357,12 +803,25 @@ public:
      */
     inline int getDeviceId(){return mDevId;}
 
+    /*!
+     * \brief Replace the transport of the XU vendor commands, e.g. with a mock camera to benchmark the command path
+     * \param transport the function executing the `UVCIOC_CTRL_QUERY` requests. An empty function restores the
+     *        `ioctl` on the video device
+     *
+     * \note While a transport is set the XU commands are sent even if no camera is opened. Do not call it while
+     * XU commands are executed by other threads
+     */
+    void setXuTransport( XuTransport transport );
+
 #ifdef SENSOR_LOG_AVAILABLE
     /*!
      * \brief Start logging to file of AEG/AGC camera registers
      * \param enable set to true to enable logging
      * \param frame_skip number of frames to skip when logging to file
      * \return true if log file can be correctly created/closed
+     *
+     * \note The registers are read by a low priority thread, not by the grabbing thread, and saved in a binary file
+     * (see \ref AecAgcLogSample). Use the `zed_open_capture_aecagc_log_to_csv` tool to convert it to CSV.
      */
     bool enableAecAgcSensLogging(bool enable, int frame_skip=10);
 
@@ -379,6 +838,16 @@ public:
      * \note CSV file will contain Adress , L value, R value
      */
     void saveAllSensorsRegisters(std::string filename);
+
+    /*!
+     * \brief Read all the ISP and sensor registers of both sensors with burst commands
+     * \param snapshot the register values
+     * \return the number of registers that cannot be read
+     *
+     * \note Use \ref writeRegisterSnapshot to save the snapshot and \ref diffRegisterSnapshots to compare it with a
+     * previous snapshot
+     */
+    int dumpRegisters(RegisterSnapshot& snapshot);
 #endif
 
 
@@ -400,10 +869,34 @@ public:
         bool resetAGCAECregisters();
 
 private:
+    friend class FrameLease;
+    friend class FrameSubscriber;
+
     void grabThreadFunc();  //!< The frame grabbing thread function
+    uint64_t mapTimestamp(uint64_t raw_ts); //!< Convert a driver timestamp to the selected clock domain
+
+    // ----> UVC buffers management
+    int queueBuffer(int index);                                 //!< Give back a UVC buffer to the driver
+    FrameLease leaseReadyFrame(uint64_t timeout_msec, bool newest); //!< Lease the newest or the oldest ready frame
+    int getFreePoolFrame();                                     //!< Reserve the least recently written frame of the pool not held by the application
+    FramePtr readRing(FrameSubscriber& sub, uint64_t timeout_msec); //!< Read the next frame of a subscriber from the ring
+
+    // ----> Frame callbacks
+    void dispatchFrame(const FramePtr& frame);  //!< Call or enqueue the frame callbacks
+    void removeAllFrameCallbacks();             //!< Unregister all the frame callbacks
+    // <---- Frame callbacks
+
+    // ----> Asynchronous controls
+    std::future<bool> enqueueControl(uint32_t key, std::function<bool()> command); //!< Enqueue a command for the control thread, replacing the pending command with the same key
+    void stopControlQueue();                    //!< Stop the control thread, failing the pending commands
+    // <---- Asynchronous controls
+    void releaseBuffer(int index);                              //!< Called by  FrameLease to release a leased UVC buffer
+    void unrefBuffer(int index);                                //!< Drop a reference on a UVC buffer, re-queuing it if not used anymore (mBufMutex must be locked)
+    // <---- UVC buffers management
 
     // ----> Low level functions
     int ll_VendorControl(uint8_t *buf, int len, int readMode, bool safe = false, bool force=false);
+    int ll_xuQuery(struct uvc_xu_control_query& query);       //!< Execute an XU request, `0` on success or the `errno` value
     int ll_get_gpio_value(int gpio_number, uint8_t* value);
     int ll_set_gpio_value(int gpio_number, uint8_t value);
     int ll_set_gpio_direction(int gpio_number, int direction);
@@ -412,6 +905,13 @@ private:
     int ll_read_sensor_register(int side, int sscb_id, uint64_t address, uint8_t *value);
     int ll_write_sensor_register(int side, int sscb_id, uint64_t address, uint8_t value);
 
+    // Burst access to contiguous registers, split in the minimum number of XU commands
+    int ll_burstPayloadSize();
+    int ll_read_system_registers(uint64_t address, uint8_t* values, int count);
+    int ll_write_system_registers(uint64_t address, const uint8_t* values, int count);
+    int ll_read_sensor_registers(int side, int sscb_id, uint64_t address, uint8_t* values, int count);
+    int ll_write_sensor_registers(int side, int sscb_id, uint64_t address, const uint8_t* values, int count);
+
     int ll_SPI_FlashProgramRead(uint8_t *pBuf, int Adr, int len, bool force=false);
 
     int ll_isp_aecagc_enable(int side, bool enable);
@@ -428,25 +928,42 @@ private:
     // <---- Low level functions
 
     // ----> Mid level functions
-    void setCameraControlSettings(int ctrl_id, int ctrl_val);
+    void loadCameraControls();                                  //!< Fill the shadow state of the V4L2 controls
+    void queryCameraControl(int ctrl_id, ControlShadow& ctrl);  //!< Fill the shadow state of a V4L2 control with its range and current value
+    ControlShadow& findCameraControl(int ctrl_id);              //!< Get the shadow state of a V4L2 control, queried if not recorded yet (mControlsMutex must be locked)
+    bool isControlVolatile(int ctrl_id);                        //!< Check if the camera can change the value of a control (mControlsMutex must be locked)
+    bool setCameraControlSettings(int ctrl_id, int ctrl_val);  //!< Write a V4L2 control, false if the value is out of range or the write failed
     void resetCameraControlSettings(int ctrl_id);
     int getCameraControlSettings(int ctrl_id);
+    bool setCameraControlsBatch(const std::vector<std::pair<int,int>>& ctrls); //!< Write the V4L2 controls that differ from the shadow state with a single request
+    bool isAECAGCActive();                                      //!< Get the AEC/AGC status from the shadow state, reading it if unknown
 
     int setGammaPreset(int side, int value);
 
+    bool writeWhiteBalance(int wb);                             //!< \ref setWhiteBalance returning the result of the V4L2 writes
+    bool writeGamma(int gamma);                                 //!< \ref setGamma returning the result of the XU and V4L2 writes
+    bool writeGain(CAM_SENS_POS cam, int gain);                 //!< \ref setGain returning the result of the XU write
+    bool writeExposure(CAM_SENS_POS cam, int exposure);         //!< \ref setExposure returning the result of the XU write
+
     int calcRawGainValue(int gain); // Convert "user gain" to "ISP gain"
     int calcGainValue(int rawGain); // Convert "ISP Gain" to "User gain"
     // <---- Mid level functions
 
     // ----> Connection control functions
     bool openCamera( uint8_t devId );                           //!< Open camera
+    bool startOpenedCamera( const CameraProfile& profile );     //!< Start the capture of the opened camera and apply the camera profile
     bool startCapture();                                        //!< Start video capture thread
     void reset();                                               //!< Reset camera connection
-    inline void stopCapture(){mStopCapture=true;}               //!< Stop video capture thread
+    void releaseBuffers();                                      //!< Release the UVC buffers, also partially allocated ones, and give the user memory back to the allocator
+    void stopCapture();                                         //!< Stop video capture thread
+    void wakeGrabThread();                                      //!< Wake up the grabbing thread waiting for a frame
     int input_set_framerate(int fps);                           //!< Set UVC framerate
     int xioctl(int fd, uint64_t IOCTL_X, void *arg);            //!< Send ioctl command
     void checkResFps();                                         //!< Check if the Framerate is correct for the selected resolution
     SL_DEVICE getCameraModel(std::string dev_name);     //!< Get the connected camera model
+    int readSerialNumber();                             //!< Read the serial number from the SPI flash of the camera
+    bool loadCachedIdentity();                          //!< Read the serial number of the camera from the identity cache file
+    void storeCachedIdentity();                         //!< Write the identity of the camera in the identity cache file
     // <---- Connection control functions
 
     typedef enum _date_time
@@ -471,13 +988,15 @@ private:
     }
 
 #ifdef SENSOR_LOG_AVAILABLE
-    void saveLogDataLeft();
-    void saveLogDataRight();
+    void requestLogSample(uint64_t frame_ts);                  //!< Ask the logging thread to sample the registers, without waiting
+    void logThreadFunc();                                       //!< The AEC/AGC registers logging thread function
+    int readLogSample(int side, AecAgcLogSample& sample);      //!< Read the AEC/AGC registers of a sensor with burst reads
+    int readRegisterBlock(RegisterBlock& block);                //!< Read a range of registers with burst reads, falling back to single reads on error
 #endif
 
 private:
     // Flags
-    bool mNewFrame=false;               //!< Indicates if a new frame is available
+    bool mNewFrame=false;               //!< Indicates if a new frame is available (protected by  mBufMutex)
     bool mInitialized=false;            //!< Inficates if the camera has been initialized
     bool mStopCapture=true;             //!< Indicates if the grabbing thread must be stopped
     bool mGrabRunning=false;            //!< Indicates if the grabbing thread is running
@@ -489,7 +1008,18 @@ private:
     int mFileDesc=-1;                   //!< The file descriptor handler
 
     std::mutex mBufMutex;               //!< Mutex for safe access to data buffer
-    std::mutex mComMutex;               //!< Mutex for safe access to UVC communication
+    std::condition_variable mNewFrameCv;//!< Signaled by the grabbing thread when a new frame is available
+    int mFrameEventFd=-1;               //!< Event file descriptor signaled when a new frame is available
+    int mWakeEventFd=-1;                //!< Event file descriptor used to wake up the grabbing thread
+    std::mutex mComMutex;               //!< Mutex for safe access to UVC control communication (XU commands)
+    std::map<int,ControlShadow> mControls; //!< Shadow state of the V4L2 controls, by control ID, filled when the camera is opened
+    XuShadow mXuShadow;                 //!< Shadow state of the camera settings written with XU commands
+    std::mutex mControlsMutex;          //!< Mutex for safe access to the shadow state of the camera controls
+    std::mutex mQueueMutex;             //!< Mutex for safe access to the UVC buffer queue, never held during control transfers
+    std::atomic<int> mXuLen{0};         //!< Length of the XU vendor control, `0` until queried
+    XuTransport mXuTransport;           //!< Custom transport of the XU requests, `ioctl` on the video device if empty
+    XuPoller mXuPoll{300,20000};       //!< Completion polling of the XU vendor commands [usec]
+    XuPoller mXuSafePoll{2000,50000}; //!< Completion polling of the XU vendor commands in safe mode (flash access) [usec]
 
     int mWidth = 0;                     //!< Frame width
     int mHeight = 0;                    //!< Frame height
@@ -497,14 +1027,57 @@ private:
     int mFps=0;                         //!< Frames per seconds
 
     SL_DEVICE mCameraModel = SL_DEVICE::NONE; //!< The camera model
-
-    Frame mLastFrame;                   //!< Last grabbed frame
+    CameraIdentity mIdentity;           //!< The identity of the camera, read when the camera is opened
+
+    Frame mLastFrame;                   //!< Last grabbed frame, copied from the leased buffer in zero-copy mode
+    std::vector<std::shared_ptr<Frame>> mFramePool; //!< Output frame buffers shared with the application
+    std::shared_ptr<Frame> mPublishedFrame; //!< Last published frame of the pool (accessed with `std::atomic_load/store`)
+    FramePtr mLastFramePin;             //!< Keeps alive the frame returned by \ref getLastFrame
+    std::unique_ptr<std::atomic<uint64_t>[]> mPoolVersions; //!< Seqlock version of each frame of the pool: `2*frame_id`, odd while writing
+    std::unique_ptr<std::atomic<uint64_t>[]> mRingSlots;    //!< Ring of the recent frames: `frame_id<<8 | pool index`
+    size_t mRingSize = 0;               //!< Number of slots of the ring, `0` if not available
+    std::atomic<uint64_t> mRingHead{0}; //!< ID of the last frame published in the ring
     uint8_t mBufCount = 2;              //!< UVC buffer count
+    uint32_t mBufMemory = 0;            //!< V4L2 memory type of the UVC buffers
+    FrameAllocator* mAllocator=nullptr; //!< Allocator of the UVC buffers in USERPTR mode
+    std::atomic<int> mDriverBufs{0};    //!< Number of UVC buffers currently queued to the driver
     uint8_t mCurrentIndex = 0;          //!< The index of the currect UVC buffer
     struct UVCBuffer *mBuffers = nullptr;  //!< UVC buffers
 
+    uint64_t mFrameCount = 0;           //!< Number of grabbed frames, used as frame index
+    std::vector<int> mBufLeases;        //!< Number of active leases for each UVC buffer
+    std::vector<Frame> mBufFrames;      //!< Information about the frame contained in each UVC buffer
+    std::deque<int> mReadyBufs;         //!< Dequeued UVC buffers ready to be leased, oldest first
+
+    std::map<uint32_t,FrameLease> mExportedLeases; //!< Leases of the exported frames, by sequence number
+    std::mutex mExportMutex;            //!< Mutex for safe access to the exported frames
+
+    FrameStats mFrameStats;             //!< Counters of the discarded frames
+    Histogram mPublishLatency;          //!< Latency between the frame dequeue and its publication [nsec]
+    Histogram mDqbufWait;               //!< Time waiting for a frame to be dequeued [nsec]
+    Histogram mMemcpyTime;              //!< Time to copy a frame in the frame pool [nsec]
+    Histogram mComMutexWait;            //!< Time waiting for mComMutex [nsec]
+    Histogram mComMutexHold;            //!< Time mComMutex is held [nsec]
+    Histogram mQueueMutexWait;          //!< Time waiting for mQueueMutex [nsec]
+    Histogram mQueueMutexHold;          //!< Time mQueueMutex is held [nsec]
+    std::atomic<uint64_t> mFrameIntervalAvg{0}; //!< Exponential moving average of the interval between frames [nsec]
+    std::atomic<uint64_t> mReceivedFrames{0};   //!< Number of received frames
+    StatsDumper mStatsDumper;           //!< Writes the metrics file periodically
+
+    std::map<int,std::shared_ptr<FrameCallbackSlot>> mCallbacks; //!< Registered frame callbacks, by ID
+    std::mutex mCallbackMutex;          //!< Mutex for safe access to the frame callbacks
+    std::atomic<int> mCallbackCount{0}; //!< Number of registered frame callbacks
+    int mNextCallbackId = 0;            //!< ID of the next registered frame callback
+
+    std::shared_ptr<ControlQueue> mControlQueue; //!< Asynchronous camera settings commands, created by the first command
+    std::mutex mControlQueueMutex;      //!< Mutex for safe creation and destruction of the control queue
+    bool mControlQueueOpen = false;     //!< Indicates if asynchronous commands are accepted, set while the camera is opened (mControlQueueMutex must be locked)
+    int64_t mLastSequence = -1;         //!< Sequence number of the last dequeued UVC buffer
+
     uint64_t mStartTs=0;                //!< Initial System Timestamp, to calculate differences [nsec]
-    uint64_t mInitTs=0;                 //!< Initial Device Timestamp, to calculate differences [usec]
+    uint64_t mInitTs=0;                 //!< Initial Device Timestamp, to calculate differences [nsec]
+    bool mMonoTsSrc=false;              //!< Indicates if the driver timestamps are taken from `CLOCK_MONOTONIC`
+    int64_t mWallOffset=0;              //!< Offset between the wall clock and `CLOCK_MONOTONIC` when the first frame is received [nsec]
 
     int mGainSegMax=0;                  //!< Maximum value of the raw gain to be used for conversion
     int mExpoureRawMax;                 //!< Maximum value of the raw exposure to be used for conversion
@@ -515,12 +1088,16 @@ private:
 
 #ifdef SENSOR_LOG_AVAILABLE
     // ----> Registers logging
-    bool mLogEnable=false;
-    std::string mLogFilenameLeft;
-    std::string mLogFilenameRight;
-    std::ofstream mLogFileLeft;
-    std::ofstream mLogFileRight;
+    std::atomic<bool> mLogEnable{false};
+    std::string mLogFilename;
+    std::ofstream mLogFile;
     int mLogFrameSkip=10;
+    std::thread mLogThread;             //!< The registers logging thread
+    std::mutex mLogMutex;               //!< Mutex for the sample requests
+    std::condition_variable mLogCv;     //!< Signals a new sample request to the logging thread
+    uint64_t mLogPendingTs=0;           //!< Timestamp of the frame of the pending sample request, `0` if none
+    bool mLogStop=false;                //!< Stops the logging thread
+    uint64_t mLogSkipped=0;             //!< Sample requests replaced by a newer request before being served
     // <---- Registers logging
 #endif
 
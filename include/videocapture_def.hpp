@@ -25,7 +25,15 @@
 #define NSEC_PER_SEC                   1000000000ULL
 #endif
 
+#define MIN_UVC_BUFFERS                2
+#define MAX_UVC_BUFFERS                16
+#define MIN_FRAME_POOL_SIZE            2
+#define MAX_FRAME_POOL_SIZE            16
+#define MIN_FRAME_RING_SIZE            1
+#define MAX_FRAME_RING_SIZE            16
+
 #include "defines.hpp"
+#include "threadconfig.hpp"
 
 namespace sl_oc {
 
@@ -75,6 +83,121 @@ enum class CAM_SENS_POS {
     LAST = 3
 };
 
+/*!
+ * \brief Policy applied by the grabbing thread when all the UVC buffers are held by the application
+ *        and no buffer is left to the driver for the next frame (see \ref VideoParams::zero_copy)
+ */
+enum class DROP_POLICY {
+    DROP_OLDEST,    //!< The oldest frame not yet leased is given back to the driver
+    DROP_NEWEST,    //!< The newest frame is given back to the driver before being leased
+    BLOCK           //!< No frame is discarded, the driver drops the frames until a buffer is released
+};
+
+/*!
+ * \brief Execution mode of the frame callbacks
+ */
+enum class CALLBACK_MODE {
+    INLINE,     //!< The callback is called by the video grabbing thread: lowest latency, but a slow callback delays the next frames
+    WORKER_POOL //!< The callback is called by dedicated worker threads fed by a bounded queue: the oldest frames are skipped if the queue is full
+};
+
+/*!
+ * \brief Clock domain of the frame timestamps
+ */
+enum class CLOCK_DOMAIN {
+    WALL,       //!< System wall clock (`CLOCK_REALTIME`), aligned once when the first frame is received
+    MONOTONIC,  //!< `CLOCK_MONOTONIC`: never jumps, stops during suspend
+    BOOTTIME    //!< `CLOCK_BOOTTIME`: never jumps, includes the time spent in suspend
+};
+
+/*!
+ * \brief Reading mode of a frame subscriber
+ */
+enum class SUBSCRIBER_MODE {
+    EVERY_FRAME,    //!< Read all the frames in order. A subscriber slower than the camera skips the frames overwritten in the ring
+    LATEST_ONLY     //!< Read only the most recent frame
+};
+
+/*!
+ * \brief Memory used for the UVC buffers
+ */
+enum class MEMORY_MODE {
+    MMAP,       //!< Buffers allocated by the driver and mapped in the application memory
+    USERPTR     //!< Buffers allocated by the application (see \ref FrameAllocator)
+};
+
+/*!
+ * \brief Interface of the allocators providing the UVC buffers memory in \ref MEMORY_MODE::USERPTR mode
+ *
+ * The allocator is called when the camera is opened, to allocate all the UVC buffers, and when the camera is closed
+ * to release them. The memory can be aligned or backed by huge pages as required by the application.
+ */
+class FrameAllocator
+{
+public:
+    virtual ~FrameAllocator() = default;
+
+    /*!
+     * \brief Allocate the memory of a UVC buffer
+     * \param size the size of the buffer in bytes
+     * \return the address of the allocated memory, `nullptr` on failure
+     */
+    virtual void* allocate( size_t size ) = 0;
+
+    /*!
+     * \brief Release the memory of a UVC buffer
+     * \param ptr the address returned by \ref allocate
+     * \param size the size of the buffer in bytes
+     */
+    virtual void deallocate( void* ptr, size_t size ) = 0;
+};
+
+/*!
+ * \brief The identity of an opened camera, read once when the camera is opened
+ */
+struct CameraIdentity
+{
+    int serial_number = -1;             //!< Camera serial number, `-1` if not available
+    SL_DEVICE model = SL_DEVICE::NONE;  //!< Camera model
+    uint16_t fw_version = 0;            //!< Firmware version (USB `bcdDevice`)
+    std::string usb_path;               //!< USB port path (e.g. `1-2.1`), empty if not available
+    int usb_bus = -1;                   //!< USB bus number
+    int usb_dev = -1;                   //!< USB device number. It changes each time the camera is plugged
+};
+
+/*!
+ * \brief Region of interest of the automatic exposure and gain control, in the coordinates of a single sensor image
+ */
+struct CameraRoi
+{
+    uint16_t x = 0;     //!< Top left corner X coordinate
+    uint16_t y = 0;     //!< Top left corner Y coordinate
+    uint16_t w = 0;     //!< Width, `0` to not change the current ROI
+    uint16_t h = 0;     //!< Height, `0` to not change the current ROI
+};
+
+/*!
+ * \brief The settings of the camera, applied all together by \ref VideoCapture::applyProfile
+ *
+ * The default profile sets the camera default values, like the `reset*` functions of \ref VideoCapture.
+ * Arrays of per-sensor values are indexed by \ref CAM_SENS_POS.
+ */
+struct CameraProfile
+{
+    int brightness = -1;            //!< Brightness in the range [0,8], `-1` for the default value
+    int contrast = -1;              //!< Contrast in the range [0,8], `-1` for the default value
+    int hue = -1;                   //!< Hue in the range [0,11], `-1` for the default value
+    int saturation = -1;            //!< Saturation in the range [0,8], `-1` for the default value
+    int sharpness = -1;             //!< Sharpness in the range [0,8], `-1` for the default value
+    int gamma = -1;                 //!< Gamma in the range [1,9], `-1` for the default value
+    bool auto_white_balance = true; //!< Automatic white balance
+    int white_balance = -1;         //!< White balance in the range [2800,6500], used if `auto_white_balance` is disabled. `-1` to not change it
+    bool aec_agc = true;            //!< Automatic exposure and gain control
+    CameraRoi aec_agc_roi[2];       //!< ROI of the automatic exposure and gain control of each sensor
+    int gain[2] = {-1,-1};          //!< Gain of each sensor in the range [0,100], used if `aec_agc` is disabled. `-1` to not change it
+    int exposure[2] = {-1,-1};      //!< Exposure of each sensor in the range [0,100], used if `aec_agc` is disabled. `-1` to not change it
+};
+
 /*!
  * \brief The camera configuration parameters
  */
@@ -87,11 +210,32 @@ typedef struct VideoParams
         res = RESOLUTION::HD2K;
         fps = FPS::FPS_15;
         verbose= sl_oc::VERBOSITY::ERROR;
+        zero_copy = false;
+        buffer_count = 2;
+        drop_policy = DROP_POLICY::DROP_OLDEST;
+        export_dmabuf = false;
+        memory = MEMORY_MODE::MMAP;
+        allocator = nullptr;
+        frame_pool_size = 3;
+        frame_ring_size = 1;
+        clock_domain = CLOCK_DOMAIN::WALL;
+        identity_cache = "";
     }
 
     RESOLUTION res; //!< Camera resolution
     FPS fps;        //!< Frames per second
     int verbose;   //!< Verbose mode
+    bool zero_copy; //!< Do not copy the UVC buffers: frames are leased with \ref VideoCapture::leaseLastFrame
+    int buffer_count;   //!< Number of UVC buffers requested to the driver, in the range [2,16]
+    DROP_POLICY drop_policy; //!< Policy applied when all the UVC buffers are held (see \ref DROP_POLICY)
+    bool export_dmabuf; //!< Export the UVC buffers as DMABUF file descriptors (requires \ref zero_copy and \ref MEMORY_MODE::MMAP)
+    MEMORY_MODE memory; //!< Memory used for the UVC buffers
+    FrameAllocator* allocator; //!< Allocator used in \ref MEMORY_MODE::USERPTR mode, `nullptr` for page aligned buffers. It must outlive the camera
+    int frame_pool_size; //!< Number of output frame buffers shared with the application when \ref zero_copy is disabled, in the range [2,16]
+    int frame_ring_size; //!< Number of recent frames kept for the frame subscribers, in the range [1,16]. The frame pool is enlarged by `frame_ring_size-1` frames
+    ThreadConfig grab_thread; //!< Scheduling, affinity, name and memory locking of the video grabbing thread
+    CLOCK_DOMAIN clock_domain; //!< Clock domain of the frame timestamps (see \ref CLOCK_DOMAIN)
+    std::string identity_cache; //!< Path of the file caching the camera identities by USB port, empty to disable it. Entries are invalidated when the camera is plugged again
 } VideoParams;
 
 /*!
@@ -128,6 +272,7 @@ static const std::vector<Resolution> cameraResolution = {
 struct UVCBuffer {
     void *start;    //!< Address of the first byte of the buffer
     size_t length;  //!< Size of the buffer
+    int dmabuf_fd;  //!< DMABUF file descriptor exported from the buffer, -1 if not exported
 };
 
 
@@ -0,0 +1,155 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+
+#ifndef XUPOLL_HPP
+#define XUPOLL_HPP
+
+#include "defines.hpp"
+
+#include <errno.h>
+#include <unistd.h>           // for usleep
+#include <algorithm>
+#include <functional>
+
+struct uvc_xu_control_query;
+
+namespace sl_oc {
+
+#define XU_BACKOFF_MIN_USEC 25      // First retry delay of a busy request
+#define XU_BACKOFF_MAX_USEC 1000    // Maximum retry delay of a busy request
+
+/*!
+ * \brief Function executing a request on the UVC extension unit (`UVCIOC_CTRL_QUERY`).
+ * It returns `0` on success or the `errno` value on failure
+ */
+typedef std::function<int(struct uvc_xu_control_query&)> XuTransport;
+
+/*!
+ * \brief The XuPoller class waits for the completion of the vendor commands sent on the UVC extension unit
+ *
+ * While a command is executing, the camera stalls the control requests ("Not Ready" UVC request error), reported by
+ * the driver as `EPIPE`. The poller waits for the completion delay of the command and then retries the stalled
+ * requests with an exponential backoff until the camera answers or the timeout expires.
+ * The delay is increased when the requests must be retried and restored when the camera answers at the first request,
+ * but it is never shorter than the initial delay: the camera can answer `UVC_GET_CUR` with the data of the previous
+ * command without reporting an error, so an answer received after a shorter delay cannot be trusted.
+ *
+ * \note The poller is not thread safe: it must be used under the lock of the UVC communication.
+ */
+class XuPoller
+{
+public:
+    /*!
+     * \brief Constructor
+     * \param initial_wait_usec the minimum delay for the completion of a command
+     * \param timeout_usec the maximum time waiting for the camera
+     */
+    XuPoller( uint32_t initial_wait_usec, uint32_t timeout_usec )
+        : mWait(initial_wait_usec), mInitialWait(initial_wait_usec), mTimeout(timeout_usec) {}
+
+    /*!
+     * \brief Send a request until the camera answers
+     * \param query the function sending the request. It returns `0` on success or the `errno` value on failure
+     * \param read true for a `UVC_GET_CUR` request, sent after the completion delay of the previous command.
+     *        false for a `UVC_SET_CUR` request, sent immediately and not retried on timeout since the camera
+     *        may have received it
+     * \return `0` on success, the `errno` value of the last request on failure
+     */
+    template<typename Query>
+    int run( Query query, bool read=true )
+    {
+        uint64_t start = getSteadyTimestamp();
+
+        if( read && mWait>0 )
+            usleep(mWait);
+
+        uint32_t backoff = XU_BACKOFF_MIN_USEC;
+        int retries = 0;
+
+        while(1)
+        {
+            int err = query();
+            uint32_t elapsed = static_cast<uint32_t>((getSteadyTimestamp()-start)/1000);
+
+            if( err==0 )
+            {
+                mLastRetries = retries;
+                if( read )
+                    adapt(retries, elapsed);
+                return 0;
+            }
+
+            if( !isBusy(err,read) || elapsed>=mTimeout )
+            {
+                mLastRetries = retries;
+                return err;
+            }
+
+            usleep(backoff);
+            backoff = std::min<uint32_t>(backoff*2, XU_BACKOFF_MAX_USEC);
+            retries++;
+        }
+    }
+
+    /*!
+     * \brief Get the current completion delay of a command
+     * \return the delay in microseconds
+     */
+    inline uint32_t currentWait() const {return mWait;}
+
+    /*!
+     * \brief Get the number of retries of the last request
+     * \return the number of retries
+     */
+    inline int lastRetries() const {return mLastRetries;}
+
+    /*!
+     * \brief Restore the initial delay, e.g. when a new camera is opened
+     */
+    inline void reset() {mWait = mInitialWait; mLastRetries = 0;}
+
+    /*!
+     * \brief Check if an error reports a busy camera
+     * \param err the `errno` value
+     * \param read true for a `UVC_GET_CUR` request. A timed out `UVC_SET_CUR` request is not retried: the camera may
+     *        have received it and the command would be executed twice
+     * \return returns true if the request can be retried
+     */
+    static inline bool isBusy( int err, bool read=true ) {return err==EPIPE || err==EBUSY || err==EAGAIN || (read && err==ETIMEDOUT);}
+
+private:
+    inline void adapt( int retries, uint32_t elapsed )
+    {
+        if( retries==0 )
+            mWait = std::max(mInitialWait, mWait - mWait/8);                // Answered at the first request: back to the initial delay
+        else
+            mWait = std::min(mTimeout, std::max(mWait + mWait/4, elapsed)); // Still busy: wait longer
+    }
+
+    uint32_t mWait;         //!< Current completion delay of a command [usec]
+    uint32_t mInitialWait;  //!< Initial and minimum completion delay of a command [usec]
+    uint32_t mTimeout;      //!< Maximum time waiting for the camera [usec]
+    int mLastRetries = 0;   //!< Number of retries of the last request
+};
+
+}
+
+#endif // XUPOLL_HPP
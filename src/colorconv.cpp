@@ -0,0 +1,449 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+
+#include "colorconv.hpp"
+
+#ifdef VIDEO_MOD_AVAILABLE
+
+#include <cstring>            // for memcpy
+#include <algorithm>          // for max
+
+#if defined(__x86_64__) || defined(__i386__)
+#define COLORCONV_X86
+#include <immintrin.h>        // for SSE2 and AVX2 intrinsics
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define COLORCONV_NEON
+#include <arm_neon.h>
+#endif
+
+// ----> BT.601 limited range coefficients, fixed point Q13
+#define YUV_SHIFT   13
+#define YUV_ROUND   (1<<(YUV_SHIFT-1))
+#define YUV_CY      9539    // 1.164383
+#define YUV_CVR     13075   // 1.596027
+#define YUV_CUG     (-3209) // -0.391762
+#define YUV_CVG     (-6660) // -0.812968
+#define YUV_CUB     16525   // 2.017232
+// <---- BT.601 limited range coefficients, fixed point Q13
+
+// Pair of 16 bit coefficients packed in a 32 bit lane for _mm_madd_epi16, built unsigned to not shift negative values
+#define YUV_PACK(hi,lo) static_cast<int>((static_cast<uint32_t>(hi)<<16)|(static_cast<uint32_t>(lo)&0xFFFF))
+
+namespace sl_oc {
+
+namespace video {
+
+/*!
+ * \brief Convert a row of YUYV pixels
+ * \param src the YUYV row
+ * \param dst the output row
+ * \param width the number of pixels, even
+ * \param cn the number of output channels: 3 or 4
+ * \param swap_rb false for BGR/BGRA order, true for RGB/RGBA order
+ */
+typedef void (*ConvertRowFunc)( const uint8_t* src, uint8_t* dst, int width, int cn, bool swap_rb );
+
+static inline uint8_t clampU8( int value )
+{
+    return static_cast<uint8_t>(value<0?0:(value>255?255:value));
+}
+
+// Reference implementation, also used for the pixels at the end of the rows by the SIMD kernels
+static void convertRowScalar( const uint8_t* src, uint8_t* dst, int width, int cn, bool swap_rb )
+{
+    const int b_idx = swap_rb?2:0;
+    const int r_idx = swap_rb?0:2;
+
+    for( int x=0; x<width; x+=2, src+=4 )
+    {
+        int u = src[1]-128;
+        int v = src[3]-128;
+
+        int r_c = YUV_CVR*v + YUV_ROUND;
+        int g_c = YUV_CUG*u + YUV_CVG*v + YUV_ROUND;
+        int b_c = YUV_CUB*u + YUV_ROUND;
+
+        for( int i=0; i<2; i++, dst+=cn )
+        {
+            int y = std::max(0, src[2*i]-16)*YUV_CY;
+            dst[b_idx] = clampU8((y+b_c)>>YUV_SHIFT);
+            dst[1] = clampU8((y+g_c)>>YUV_SHIFT);
+            dst[r_idx] = clampU8((y+r_c)>>YUV_SHIFT);
+            if( cn==4 )
+                dst[3] = 255;
+        }
+    }
+}
+
+#ifdef COLORCONV_X86
+// ----> SSE2
+// Convert 8 YUYV pixels to 8 R, G, B values (signed 16 bit, not saturated)
+__attribute__((target("sse2")))
+static inline void yuyvToRgb16Sse2( __m128i yuyv, __m128i& r, __m128i& g, __m128i& b )
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i round = _mm_set1_epi32(YUV_ROUND);
+    const __m128i k_yv_r = _mm_set1_epi32(YUV_PACK(YUV_CVR,YUV_CY));
+    const __m128i k_yu_g = _mm_set1_epi32(YUV_PACK(YUV_CUG,YUV_CY));
+    const __m128i k_v_g = _mm_set1_epi32(YUV_PACK(0,YUV_CVG));
+    const __m128i k_yu_b = _mm_set1_epi32(YUV_PACK(YUV_CUB,YUV_CY));
+
+    // Y: low byte of each 16 bit lane, U/V: high byte
+    __m128i y = _mm_max_epi16(_mm_sub_epi16(_mm_and_si128(yuyv, _mm_set1_epi16(0x00FF)), _mm_set1_epi16(16)), zero);
+    __m128i c = _mm_sub_epi16(_mm_srli_epi16(yuyv, 8), _mm_set1_epi16(128));
+
+    // U and V of each pixel
+    __m128i u = _mm_shufflehi_epi16(_mm_shufflelo_epi16(c, _MM_SHUFFLE(2,2,0,0)), _MM_SHUFFLE(2,2,0,0));
+    __m128i v = _mm_shufflehi_epi16(_mm_shufflelo_epi16(c, _MM_SHUFFLE(3,3,1,1)), _MM_SHUFFLE(3,3,1,1));
+
+    __m128i yu_lo = _mm_unpacklo_epi16(y, u);
+    __m128i yu_hi = _mm_unpackhi_epi16(y, u);
+    __m128i yv_lo = _mm_unpacklo_epi16(y, v);
+    __m128i yv_hi = _mm_unpackhi_epi16(y, v);
+    __m128i v_lo = _mm_unpacklo_epi16(v, zero);
+    __m128i v_hi = _mm_unpackhi_epi16(v, zero);
+
+    __m128i r_lo = _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(yv_lo, k_yv_r), round), YUV_SHIFT);
+    __m128i r_hi = _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(yv_hi, k_yv_r), round), YUV_SHIFT);
+    __m128i g_lo = _mm_srai_epi32(_mm_add_epi32(_mm_add_epi32(_mm_madd_epi16(yu_lo, k_yu_g), _mm_madd_epi16(v_lo, k_v_g)), round), YUV_SHIFT);
+    __m128i g_hi = _mm_srai_epi32(_mm_add_epi32(_mm_add_epi32(_mm_madd_epi16(yu_hi, k_yu_g), _mm_madd_epi16(v_hi, k_v_g)), round), YUV_SHIFT);
+    __m128i b_lo = _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(yu_lo, k_yu_b), round), YUV_SHIFT);
+    __m128i b_hi = _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(yu_hi, k_yu_b), round), YUV_SHIFT);
+
+    r = _mm_packs_epi32(r_lo, r_hi);
+    g = _mm_packs_epi32(g_lo, g_hi);
+    b = _mm_packs_epi32(b_lo, b_hi);
+}
+
+// Store 4 pixels of 4 bytes as 3 or 4 bytes pixels
+__attribute__((target("sse2")))
+static inline void storePixelsSse2( uint8_t* dst, __m128i px, int cn )
+{
+    if( cn==4 )
+    {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), px);
+        return;
+    }
+
+    for( int i=0; i<4; i++, dst+=3 )
+    {
+        int32_t val = _mm_cvtsi128_si32(px);
+        memcpy(dst, &val, 3);
+        px = _mm_srli_si128(px, 4);
+    }
+}
+
+__attribute__((target("sse2")))
+static void convertRowSse2( const uint8_t* src, uint8_t* dst, int width, int cn, bool swap_rb )
+{
+    const __m128i alpha = _mm_set1_epi8(static_cast<char>(0xFF));
+
+    int x = 0;
+    for( ; x+16<=width; x+=16, src+=32, dst+=16*cn )
+    {
+        __m128i r0, g0, b0, r1, g1, b1;
+        yuyvToRgb16Sse2(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src)), r0, g0, b0);
+        yuyvToRgb16Sse2(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src+16)), r1, g1, b1);
+
+        __m128i r = _mm_packus_epi16(r0, r1);
+        __m128i g = _mm_packus_epi16(g0, g1);
+        __m128i b = _mm_packus_epi16(b0, b1);
+        __m128i c0 = swap_rb?r:b;
+        __m128i c2 = swap_rb?b:r;
+
+        // ----> Interleave the channels
+        __m128i c01_lo = _mm_unpacklo_epi8(c0, g);
+        __m128i c01_hi = _mm_unpackhi_epi8(c0, g);
+        __m128i c2a_lo = _mm_unpacklo_epi8(c2, alpha);
+        __m128i c2a_hi = _mm_unpackhi_epi8(c2, alpha);
+
+        storePixelsSse2(dst, _mm_unpacklo_epi16(c01_lo, c2a_lo), cn);
+        storePixelsSse2(dst+4*cn, _mm_unpackhi_epi16(c01_lo, c2a_lo), cn);
+        storePixelsSse2(dst+8*cn, _mm_unpacklo_epi16(c01_hi, c2a_hi), cn);
+        storePixelsSse2(dst+12*cn, _mm_unpackhi_epi16(c01_hi, c2a_hi), cn);
+        // <---- Interleave the channels
+    }
+
+    convertRowScalar(src, dst, width-x, cn, swap_rb);
+}
+// <---- SSE2
+
+// ----> AVX2
+// Convert 16 YUYV pixels to 16 R, G, B values (signed 16 bit, not saturated). Each 128 bit lane holds 8 pixels
+__attribute__((target("avx2")))
+static inline void yuyvToRgb16Avx2( __m256i yuyv, __m256i& r, __m256i& g, __m256i& b )
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i round = _mm256_set1_epi32(YUV_ROUND);
+    const __m256i k_yv_r = _mm256_set1_epi32(YUV_PACK(YUV_CVR,YUV_CY));
+    const __m256i k_yu_g = _mm256_set1_epi32(YUV_PACK(YUV_CUG,YUV_CY));
+    const __m256i k_v_g = _mm256_set1_epi32(YUV_PACK(0,YUV_CVG));
+    const __m256i k_yu_b = _mm256_set1_epi32(YUV_PACK(YUV_CUB,YUV_CY));
+
+    __m256i y = _mm256_max_epi16(_mm256_sub_epi16(_mm256_and_si256(yuyv, _mm256_set1_epi16(0x00FF)), _mm256_set1_epi16(16)), zero);
+    __m256i c = _mm256_sub_epi16(_mm256_srli_epi16(yuyv, 8), _mm256_set1_epi16(128));
+
+    __m256i u = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(c, _MM_SHUFFLE(2,2,0,0)), _MM_SHUFFLE(2,2,0,0));
+    __m256i v = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(c, _MM_SHUFFLE(3,3,1,1)), _MM_SHUFFLE(3,3,1,1));
+
+    __m256i yu_lo = _mm256_unpacklo_epi16(y, u);
+    __m256i yu_hi = _mm256_unpackhi_epi16(y, u);
+    __m256i yv_lo = _mm256_unpacklo_epi16(y, v);
+    __m256i yv_hi = _mm256_unpackhi_epi16(y, v);
+    __m256i v_lo = _mm256_unpacklo_epi16(v, zero);
+    __m256i v_hi = _mm256_unpackhi_epi16(v, zero);
+
+    __m256i r_lo = _mm256_srai_epi32(_mm256_add_epi32(_mm256_madd_epi16(yv_lo, k_yv_r), round), YUV_SHIFT);
+    __m256i r_hi = _mm256_srai_epi32(_mm256_add_epi32(_mm256_madd_epi16(yv_hi, k_yv_r), round), YUV_SHIFT);
+    __m256i g_lo = _mm256_srai_epi32(_mm256_add_epi32(_mm256_add_epi32(_mm256_madd_epi16(yu_lo, k_yu_g), _mm256_madd_epi16(v_lo, k_v_g)), round), YUV_SHIFT);
+    __m256i g_hi = _mm256_srai_epi32(_mm256_add_epi32(_mm256_add_epi32(_mm256_madd_epi16(yu_hi, k_yu_g), _mm256_madd_epi16(v_hi, k_v_g)), round), YUV_SHIFT);
+    __m256i b_lo = _mm256_srai_epi32(_mm256_add_epi32(_mm256_madd_epi16(yu_lo, k_yu_b), round), YUV_SHIFT);
+    __m256i b_hi = _mm256_srai_epi32(_mm256_add_epi32(_mm256_madd_epi16(yu_hi, k_yu_b), round), YUV_SHIFT);
+
+    r = _mm256_packs_epi32(r_lo, r_hi);
+    g = _mm256_packs_epi32(g_lo, g_hi);
+    b = _mm256_packs_epi32(b_lo, b_hi);
+}
+
+// Store 4 pixels of 4 bytes as 3 or 4 bytes pixels
+__attribute__((target("avx2")))
+static inline void storePixelsAvx2( uint8_t* dst, __m128i px, int cn )
+{
+    if( cn==4 )
+    {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), px);
+        return;
+    }
+
+    const __m128i pack3 = _mm_setr_epi8(0,1,2,4,5,6,8,9,10,12,13,14,-1,-1,-1,-1);
+    px = _mm_shuffle_epi8(px, pack3);
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(dst), px);
+    int32_t val = _mm_cvtsi128_si32(_mm_srli_si128(px, 8));
+    memcpy(dst+8, &val, 4);
+}
+
+__attribute__((target("avx2")))
+static void convertRowAvx2( const uint8_t* src, uint8_t* dst, int width, int cn, bool swap_rb )
+{
+    const __m256i alpha = _mm256_set1_epi8(static_cast<char>(0xFF));
+
+    int x = 0;
+    for( ; x+32<=width; x+=32, src+=64, dst+=32*cn )
+    {
+        __m256i r0, g0, b0, r1, g1, b1;
+        yuyvToRgb16Avx2(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(src)), r0, g0, b0);
+        yuyvToRgb16Avx2(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(src+32)), r1, g1, b1);
+
+        // The lane-wise pack interleaves the 8 pixels groups: restore the pixel order
+        __m256i r = _mm256_permute4x64_epi64(_mm256_packus_epi16(r0, r1), _MM_SHUFFLE(3,1,2,0));
+        __m256i g = _mm256_permute4x64_epi64(_mm256_packus_epi16(g0, g1), _MM_SHUFFLE(3,1,2,0));
+        __m256i b = _mm256_permute4x64_epi64(_mm256_packus_epi16(b0, b1), _MM_SHUFFLE(3,1,2,0));
+        __m256i c0 = swap_rb?r:b;
+        __m256i c2 = swap_rb?b:r;
+
+        // ----> Interleave the channels
+        __m256i c01_lo = _mm256_unpacklo_epi8(c0, g);
+        __m256i c01_hi = _mm256_unpackhi_epi8(c0, g);
+        __m256i c2a_lo = _mm256_unpacklo_epi8(c2, alpha);
+        __m256i c2a_hi = _mm256_unpackhi_epi8(c2, alpha);
+
+        // Pixels [0-3,16-19], [4-7,20-23], [8-11,24-27], [12-15,28-31]
+        __m256i px0 = _mm256_unpacklo_epi16(c01_lo, c2a_lo);
+        __m256i px1 = _mm256_unpackhi_epi16(c01_lo, c2a_lo);
+        __m256i px2 = _mm256_unpacklo_epi16(c01_hi, c2a_hi);
+        __m256i px3 = _mm256_unpackhi_epi16(c01_hi, c2a_hi);
+
+        storePixelsAvx2(dst, _mm256_castsi256_si128(px0), cn);
+        storePixelsAvx2(dst+4*cn, _mm256_castsi256_si128(px1), cn);
+        storePixelsAvx2(dst+8*cn, _mm256_castsi256_si128(px2), cn);
+        storePixelsAvx2(dst+12*cn, _mm256_castsi256_si128(px3), cn);
+        storePixelsAvx2(dst+16*cn, _mm256_extracti128_si256(px0, 1), cn);
+        storePixelsAvx2(dst+20*cn, _mm256_extracti128_si256(px1, 1), cn);
+        storePixelsAvx2(dst+24*cn, _mm256_extracti128_si256(px2, 1), cn);
+        storePixelsAvx2(dst+28*cn, _mm256_extracti128_si256(px3, 1), cn);
+        // <---- Interleave the channels
+    }
+
+    convertRowScalar(src, dst, width-x, cn, swap_rb);
+}
+// <---- AVX2
+#endif // COLORCONV_X86
+
+#ifdef COLORCONV_NEON
+// ----> NEON
+// Convert 8 pixels with the same arithmetic of the scalar implementation
+static inline uint8x8_t yuvToChannelNeon( int16x8_t y, int16x8_t c0, int16_t k0, int16x8_t c1, int16_t k1 )
+{
+    int32x4_t lo = vmull_n_s16(vget_low_s16(y), YUV_CY);
+    int32x4_t hi = vmull_n_s16(vget_high_s16(y), YUV_CY);
+    lo = vmlal_n_s16(lo, vget_low_s16(c0), k0);
+    hi = vmlal_n_s16(hi, vget_high_s16(c0), k0);
+    lo = vmlal_n_s16(lo, vget_low_s16(c1), k1);
+    hi = vmlal_n_s16(hi, vget_high_s16(c1), k1);
+
+    // Rounding shift: (x + YUV_ROUND) >> YUV_SHIFT
+    int16x8_t val = vcombine_s16(vqmovn_s32(vrshrq_n_s32(lo, YUV_SHIFT)), vqmovn_s32(vrshrq_n_s32(hi, YUV_SHIFT)));
+    return vqmovun_s16(val);
+}
+
+static void convertRowNeon( const uint8_t* src, uint8_t* dst, int width, int cn, bool swap_rb )
+{
+    const int16x8_t zero = vdupq_n_s16(0);
+
+    int x = 0;
+    for( ; x+16<=width; x+=16, src+=32, dst+=16*cn )
+    {
+        // Even pixels Y, U, odd pixels Y, V
+        uint8x8x4_t yuyv = vld4_u8(src);
+
+        int16x8_t y_even = vmaxq_s16(vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(yuyv.val[0])), vdupq_n_s16(16)), zero);
+        int16x8_t y_odd = vmaxq_s16(vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(yuyv.val[2])), vdupq_n_s16(16)), zero);
+        int16x8_t u = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(yuyv.val[1])), vdupq_n_s16(128));
+        int16x8_t v = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(yuyv.val[3])), vdupq_n_s16(128));
+
+        uint8x8x2_t r = vzip_u8(yuvToChannelNeon(y_even, v, YUV_CVR, u, 0), yuvToChannelNeon(y_odd, v, YUV_CVR, u, 0));
+        uint8x8x2_t g = vzip_u8(yuvToChannelNeon(y_even, u, YUV_CUG, v, YUV_CVG), yuvToChannelNeon(y_odd, u, YUV_CUG, v, YUV_CVG));
+        uint8x8x2_t b = vzip_u8(yuvToChannelNeon(y_even, u, YUV_CUB, v, 0), yuvToChannelNeon(y_odd, u, YUV_CUB, v, 0));
+
+        uint8x16_t r16 = vcombine_u8(r.val[0], r.val[1]);
+        uint8x16_t g16 = vcombine_u8(g.val[0], g.val[1]);
+        uint8x16_t b16 = vcombine_u8(b.val[0], b.val[1]);
+
+        if( cn==4 )
+        {
+            uint8x16x4_t px;
+            px.val[0] = swap_rb?r16:b16;
+            px.val[1] = g16;
+            px.val[2] = swap_rb?b16:r16;
+            px.val[3] = vdupq_n_u8(255);
+            vst4q_u8(dst, px);
+        }
+        else
+        {
+            uint8x16x3_t px;
+            px.val[0] = swap_rb?r16:b16;
+            px.val[1] = g16;
+            px.val[2] = swap_rb?b16:r16;
+            vst3q_u8(dst, px);
+        }
+    }
+
+    convertRowScalar(src, dst, width-x, cn, swap_rb);
+}
+// <---- NEON
+#endif // COLORCONV_NEON
+
+bool isSimdLevelSupported( SIMD_LEVEL level )
+{
+    switch(level)
+    {
+    case SIMD_LEVEL::AUTO:
+    case SIMD_LEVEL::SCALAR:
+        return true;
+#ifdef COLORCONV_X86
+    case SIMD_LEVEL::SSE2:
+        return __builtin_cpu_supports("sse2");
+    case SIMD_LEVEL::AVX2:
+        return __builtin_cpu_supports("avx2");
+#endif
+#ifdef COLORCONV_NEON
+    case SIMD_LEVEL::NEON:
+        return true; // Enabled at compile time (e.g. `EMBEDDED_ARM` builds), always available on AArch64
+#endif
+    default:
+        return false;
+    }
+}
+
+SIMD_LEVEL getBestSimdLevel()
+{
+    static const SIMD_LEVEL best = []{
+        const SIMD_LEVEL levels[] = {SIMD_LEVEL::AVX2, SIMD_LEVEL::SSE2, SIMD_LEVEL::NEON};
+        for( SIMD_LEVEL level : levels )
+        {
+            if( isSimdLevelSupported(level) )
+                return level;
+        }
+        return SIMD_LEVEL::SCALAR;
+    }();
+
+    return best;
+}
+
+static ConvertRowFunc getConvertRowFunc( SIMD_LEVEL level )
+{
+    if( level==SIMD_LEVEL::AUTO )
+        level = getBestSimdLevel();
+    else if( !isSimdLevelSupported(level) )
+        return nullptr;
+
+    switch(level)
+    {
+#ifdef COLORCONV_X86
+    case SIMD_LEVEL::SSE2:
+        return convertRowSse2;
+    case SIMD_LEVEL::AVX2:
+        return convertRowAvx2;
+#endif
+#ifdef COLORCONV_NEON
+    case SIMD_LEVEL::NEON:
+        return convertRowNeon;
+#endif
+    default:
+        return convertRowScalar;
+    }
+}
+
+bool convertYUYV( const uint8_t* src, size_t src_stride, uint8_t* dst, size_t dst_stride,
+                  int width, int height, COLOR_FORMAT format, SIMD_LEVEL level/*=SIMD_LEVEL::AUTO*/ )
+{
+    int cn = getColorFormatChannels(format);
+    bool swap_rb = (format==COLOR_FORMAT::RGB || format==COLOR_FORMAT::RGBA);
+
+    if( !src || !dst || width<=0 || height<=0 || (width%2)!=0 )
+        return false;
+    if( src_stride<static_cast<size_t>(width)*2 || dst_stride<static_cast<size_t>(width)*cn )
+        return false;
+
+    ConvertRowFunc convert_row = getConvertRowFunc(level);
+    if( !convert_row )
+        return false;
+
+    for( int row=0; row<height; row++ )
+        convert_row(src+row*src_stride, dst+row*dst_stride, width, cn, swap_rb);
+
+    return true;
+}
+
+bool convertFrame( const Frame& frame, uint8_t* dst, size_t dst_stride,
+                   COLOR_FORMAT format, SIMD_LEVEL level/*=SIMD_LEVEL::AUTO*/ )
+{
+    return convertYUYV(frame.data, static_cast<size_t>(frame.width)*2, dst, dst_stride,
+                       frame.width, frame.height, format, level);
+}
+
+}
+
+}
+
+#endif // VIDEO_MOD_AVAILABLE
@@ -0,0 +1,319 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+
+#include "discovery.hpp"
+
+#include <fstream>
+#include <algorithm>
+
+#include <dirent.h>           // for opendir, readdir, closedir
+#include <limits.h>           // for PATH_MAX
+#include <stdlib.h>           // for realpath, strtol
+#include <unistd.h>           // for access
+
+namespace sl_oc {
+
+namespace {
+
+const std::string VIDEO_CLASS_DIR = "/sys/class/video4linux/";
+
+// Read the first line of a sysfs attribute
+bool readSysfsAttr( const std::string& path, std::string& value )
+{
+    std::ifstream file(path);
+    if( !std::getline(file, value) )
+        return false;
+
+    value.erase(value.find_last_not_of(" \t\r\n")+1);
+    return true;
+}
+
+// Read a sysfs attribute in hexadecimal format (e.g. `idVendor`)
+bool readSysfsHex( const std::string& path, uint16_t& value )
+{
+    std::string str;
+    if( !readSysfsAttr(path, str) || str.empty() )
+        return false;
+
+    char* end = nullptr;
+    long val = strtol(str.c_str(), &end, 16);
+    if( *end!='\0' || val<0 || val>0xFFFF )
+        return false;
+
+    value = static_cast<uint16_t>(val);
+    return true;
+}
+
+// Convert the USB serial string to serial number, `-1` if it is not a decimal number
+int parseSerial( const std::string& str )
+{
+    if( str.empty() )
+        return -1;
+
+    char* end = nullptr;
+    long val = strtol(str.c_str(), &end, 10);
+    if( *end!='\0' || val<=0 || val>INT32_MAX )
+        return -1;
+
+    return static_cast<int>(val);
+}
+
+std::string realPath( const std::string& path )
+{
+    char buf[PATH_MAX];
+    if( realpath(path.c_str(), buf)==nullptr )
+        return std::string();
+    return std::string(buf);
+}
+
+std::string parentDir( const std::string& path )
+{
+    size_t pos = path.find_last_of('/');
+    if( pos==std::string::npos || pos==0 )
+        return std::string();
+    return path.substr(0, pos);
+}
+
+std::string baseName( const std::string& path )
+{
+    size_t pos = path.find_last_of('/');
+    return (pos==std::string::npos)?path:path.substr(pos+1);
+}
+
+// Walk up the sysfs tree from an interface or class device to the USB device owning it
+std::string usbDeviceDir( const std::string& sysfs_path )
+{
+    std::string dir = realPath(sysfs_path);
+    while( !dir.empty() && dir!="/sys/devices" )
+    {
+        if( access((dir+"/idVendor").c_str(), F_OK)==0 )
+            return dir;
+        dir = parentDir(dir);
+    }
+    return std::string();
+}
+
+// List the entries of a directory starting with `prefix`
+std::vector<std::string> listDir( const std::string& path, const std::string& prefix )
+{
+    std::vector<std::string> entries;
+
+    DIR* dir = opendir(path.c_str());
+    if( !dir )
+        return entries;
+
+    struct dirent* ent;
+    while( (ent=readdir(dir))!=nullptr )
+    {
+        std::string name = ent->d_name;
+        if( name.compare(0, prefix.size(), prefix)==0 )
+            entries.push_back(name);
+    }
+    closedir(dir);
+
+    return entries;
+}
+
+bool isVideoPid( uint16_t pid )
+{
+    return pid==SL_USB_PROD_ZED_REVA || pid==SL_USB_PROD_ZED_M_REVA ||
+            pid==SL_USB_PROD_ZED_REVB || pid==SL_USB_PROD_ZED_M_REVB ||
+            pid==SL_USB_PROD_ZED_2_REVB || pid==SL_USB_PROD_ZED_2i;
+}
+
+bool isSensorsPid( uint16_t pid )
+{
+    return pid==SL_USB_PROD_MCU_ZEDM_REVA || pid==SL_USB_PROD_MCU_ZED2_REVA ||
+            pid==SL_USB_PROD_MCU_ZED2i_REVA;
+}
+
+// Read the USB information of a video device
+bool readVideoDevice( const std::string& name, CameraDescriptor& desc, std::string& usb_dir )
+{
+    std::string dev_dir = VIDEO_CLASS_DIR + name;
+
+    // Skip the metadata nodes: only the first node of each interface captures frames
+    std::string index;
+    if( readSysfsAttr(dev_dir+"/index", index) && index!="0" )
+        return false;
+
+    usb_dir = usbDeviceDir(dev_dir+"/device");
+    if( usb_dir.empty() )
+        return false;
+
+    uint16_t vid = 0, pid = 0;
+    if( !readSysfsHex(usb_dir+"/idVendor", vid) || vid!=SL_USB_VENDOR ||
+            !readSysfsHex(usb_dir+"/idProduct", pid) || !isVideoPid(pid) )
+        return false;
+
+    desc = CameraDescriptor();
+    desc.video_pid = pid;
+    desc.video_id = atoi(name.c_str()+5);
+    desc.video_path = "/dev/" + name;
+    desc.usb_path = baseName(usb_dir);
+    readSysfsHex(usb_dir+"/bcdDevice", desc.fw_version);
+
+    std::string value;
+    if( readSysfsAttr(usb_dir+"/busnum", value) )
+        desc.usb_bus = atoi(value.c_str());
+    if( readSysfsAttr(usb_dir+"/devnum", value) )
+        desc.usb_dev = atoi(value.c_str());
+    if( readSysfsAttr(usb_dir+"/serial", value) )
+        desc.serial_number = parseSerial(value);
+
+    return true;
+}
+
+// A sensors HID device found in sysfs
+struct HidNode
+{
+    std::string path;       // e.g. /dev/hidraw0
+    std::string usb_parent; // Sysfs path of the parent of the USB device (the camera internal hub)
+    uint16_t pid = 0;
+    int sn = -1;
+    bool used = false;
+};
+
+std::vector<HidNode> enumerateHid()
+{
+    std::vector<HidNode> nodes;
+
+    const std::string class_dir = "/sys/class/hidraw/";
+    for( const std::string& name : listDir(class_dir, "hidraw") )
+    {
+        std::string usb_dir = usbDeviceDir(class_dir + name + "/device");
+        if( usb_dir.empty() )
+            continue;
+
+        uint16_t vid = 0, pid = 0;
+        if( !readSysfsHex(usb_dir+"/idVendor", vid) || vid!=SL_USB_VENDOR ||
+                !readSysfsHex(usb_dir+"/idProduct", pid) || !isSensorsPid(pid) )
+            continue;
+
+        HidNode node;
+        node.path = "/dev/" + name;
+        node.usb_parent = parentDir(usb_dir);
+        node.pid = pid;
+
+        std::string serial;
+        if( readSysfsAttr(usb_dir+"/serial", serial) )
+            node.sn = parseSerial(serial);
+
+        nodes.push_back(node);
+    }
+
+    return nodes;
+}
+
+}
+
+std::vector<CameraDescriptor> discoverCameras()
+{
+    std::vector<CameraDescriptor> cameras;
+    std::vector<std::string> usb_parents;
+
+    // ----> Video devices
+    for( const std::string& name : listDir(VIDEO_CLASS_DIR, "video") )
+    {
+        CameraDescriptor desc;
+        std::string usb_dir;
+        if( !readVideoDevice(name, desc, usb_dir) )
+            continue;
+
+        cameras.push_back(desc);
+        usb_parents.push_back(parentDir(usb_dir));
+    }
+    // <---- Video devices
+
+    // ----> Correlate the sensors devices
+    std::vector<HidNode> hid_nodes = enumerateHid();
+
+    for( size_t i=0; i<cameras.size(); i++ )
+    {
+        CameraDescriptor& desc = cameras[i];
+        HidNode* match = nullptr;
+
+        // Same serial number, if available
+        if( desc.serial_number!=-1 )
+        {
+            for( HidNode& node : hid_nodes )
+            {
+                if( !node.used && node.sn==desc.serial_number )
+                {
+                    match = &node;
+                    break;
+                }
+            }
+        }
+
+        // Same USB parent: the video and the sensors devices are behind the camera internal hub.
+        // The parent is ambiguous if more than one camera is connected to the same hub without internal hub.
+        if( !match && std::count(usb_parents.begin(), usb_parents.end(), usb_parents[i])==1 )
+        {
+            for( HidNode& node : hid_nodes )
+            {
+                if( !node.used && node.usb_parent==usb_parents[i] )
+                {
+                    match = &node;
+                    break;
+                }
+            }
+        }
+
+        if( match )
+        {
+            match->used = true;
+            desc.sensors_pid = match->pid;
+            desc.hid_path = match->path;
+            if( desc.serial_number==-1 )
+                desc.serial_number = match->sn;
+        }
+    }
+    // <---- Correlate the sensors devices
+
+    std::sort(cameras.begin(), cameras.end(), [](const CameraDescriptor& a, const CameraDescriptor& b){
+        return a.video_id<b.video_id;
+    });
+
+    return cameras;
+}
+
+bool describeVideoDevice( int video_id, CameraDescriptor& desc )
+{
+    std::string usb_dir;
+    return readVideoDevice("video"+std::to_string(video_id), desc, usb_dir);
+}
+
+bool findCamera( int sn, CameraDescriptor& desc )
+{
+    std::vector<CameraDescriptor> cameras = discoverCameras();
+    for( const CameraDescriptor& cam : cameras )
+    {
+        if( cam.serial_number==sn )
+        {
+            desc = cam;
+            return true;
+        }
+    }
+    return false;
+}
+
+}
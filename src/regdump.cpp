@@ -0,0 +1,244 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+
+#include "regdump.hpp"
+
+#include <cstring>            // for memcpy
+#include <fstream>
+#include <iterator>
+
+namespace sl_oc {
+
+namespace video {
+
+#define REG_DUMP_WRITER_BUFFER      65536       // Size of the buffer of the snapshot writer [bytes]
+#define REG_DUMP_BLOCK_HEADER       16          // Size of the header of a register range in the file [bytes]
+#define REG_DUMP_CHANGE_SIZE        6           // Size of a changed register in the file [bytes]
+
+/*!
+ * \brief The RegisterFileWriter class writes binary values to a file through a memory buffer
+ */
+class RegisterFileWriter
+{
+public:
+    RegisterFileWriter( const std::string& path ) : mFile(path, std::ofstream::out | std::ofstream::binary | std::ofstream::trunc)
+    {
+        mBuffer.reserve(REG_DUMP_WRITER_BUFFER);
+    }
+    ~RegisterFileWriter() {flush();}
+
+    inline bool isOpen() const {return mFile.is_open();}
+
+    template<typename T>
+    inline void put( const T& value ) {put(&value, sizeof(T));}
+
+    void put( const void* data, size_t size )
+    {
+        if( mBuffer.size()+size>REG_DUMP_WRITER_BUFFER )
+            flush();
+        if( size>REG_DUMP_WRITER_BUFFER )
+        {
+            mFile.write(static_cast<const char*>(data), size);
+            return;
+        }
+        mBuffer.insert(mBuffer.end(), static_cast<const char*>(data), static_cast<const char*>(data)+size);
+    }
+
+    bool flush()
+    {
+        if( !mBuffer.empty() )
+            mFile.write(mBuffer.data(), mBuffer.size());
+        mBuffer.clear();
+        mFile.flush();
+        return mFile.good();
+    }
+
+private:
+    std::ofstream mFile;
+    std::vector<char> mBuffer;
+};
+
+std::vector<RegisterChange> diffRegisterSnapshots( const RegisterSnapshot& prev, const RegisterSnapshot& cur )
+{
+    std::vector<RegisterChange> changes;
+
+    for( const RegisterBlock& block : cur.blocks )
+    {
+        const RegisterBlock* prev_block = prev.findBlock(block.bank, block.side, block.address);
+        if( !prev_block || prev_block->values.size()!=block.values.size() )
+            continue;
+
+        for( size_t i=0; i<block.values.size(); i++ )
+        {
+            int old_value = prev_block->valid[i]?prev_block->values[i]:-1;
+            int new_value = block.valid[i]?block.values[i]:-1;
+            if( old_value!=new_value )
+                changes.push_back({block.bank, block.side, block.address+i, old_value, new_value});
+        }
+    }
+
+    return changes;
+}
+
+bool writeRegisterSnapshot( const std::string& path, const RegisterSnapshot& snap, const RegisterSnapshot* base )
+{
+    RegisterFileWriter writer(path);
+    if( !writer.isOpen() )
+        return false;
+
+    writer.put(REG_DUMP_MAGIC, 8);
+    writer.put<uint32_t>(REG_DUMP_VERSION);
+    writer.put<uint64_t>(snap.timestamp);
+    writer.put<int32_t>(snap.serial_number);
+    writer.put<uint32_t>(static_cast<uint32_t>(snap.blocks.size()));
+
+    for( const RegisterBlock& block : snap.blocks )
+    {
+        const RegisterBlock* base_block = base?base->findBlock(block.bank, block.side, block.address):nullptr;
+        if( base_block && base_block->values.size()!=block.values.size() )
+            base_block = nullptr;
+
+        writer.put<uint8_t>(static_cast<uint8_t>(block.bank));
+        writer.put<uint8_t>(block.side);
+        writer.put<uint8_t>(base_block?1:0);
+        writer.put<uint8_t>(0);
+        writer.put<uint32_t>(static_cast<uint32_t>(block.values.size()));
+        writer.put<uint64_t>(block.address);
+
+        if( !base_block )
+        {
+            writer.put(block.values.data(), block.values.size());
+            writer.put(block.valid.data(), block.valid.size());
+            continue;
+        }
+
+        // ----> Changed registers only
+        std::vector<uint32_t> changed;
+        for( size_t i=0; i<block.values.size(); i++ )
+        {
+            if( block.values[i]!=base_block->values[i] || block.valid[i]!=base_block->valid[i] )
+                changed.push_back(static_cast<uint32_t>(i));
+        }
+
+        writer.put<uint32_t>(static_cast<uint32_t>(changed.size()));
+        for( uint32_t offset : changed )
+        {
+            writer.put<uint32_t>(offset);
+            writer.put<uint8_t>(block.values[offset]);
+            writer.put<uint8_t>(block.valid[offset]);
+        }
+        // <---- Changed registers only
+    }
+
+    return writer.flush();
+}
+
+bool readRegisterSnapshot( const std::string& path, RegisterSnapshot& snap, const RegisterSnapshot* base )
+{
+    snap = RegisterSnapshot();
+
+    std::ifstream file(path, std::ifstream::in | std::ifstream::binary);
+    if( !file.is_open() )
+        return false;
+
+    std::vector<char> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    size_t pos = 0;
+
+    auto get = [&data,&pos]( void* dst, size_t size ) {
+        if( size>data.size()-pos )
+            return false;
+        memcpy(dst, data.data()+pos, size);
+        pos += size;
+        return true;
+    };
+
+    // The sizes read from the file are checked against the remaining data before allocating memory
+    auto available = [&data,&pos]( size_t count, size_t item_size ) {
+        return count<=(data.size()-pos)/item_size;
+    };
+
+    // ----> Header
+    char magic[8];
+    uint32_t version = 0, block_count = 0;
+    if( !get(magic, 8) || memcmp(magic, REG_DUMP_MAGIC, 8)!=0 || !get(&version, 4) || version!=REG_DUMP_VERSION ||
+            !get(&snap.timestamp, 8) || !get(&snap.serial_number, 4) || !get(&block_count, 4) ||
+            !available(block_count, REG_DUMP_BLOCK_HEADER) )
+        return false;
+    // <---- Header
+
+    snap.blocks.reserve(block_count);
+
+    for( uint32_t b=0; b<block_count; b++ )
+    {
+        uint8_t bank = 0, delta = 0, reserved = 0;
+        uint32_t count = 0;
+        RegisterBlock block;
+        if( !get(&bank, 1) || !get(&block.side, 1) || !get(&delta, 1) || !get(&reserved, 1) ||
+                !get(&count, 4) || !get(&block.address, 8) )
+            return false;
+        block.bank = static_cast<REG_BANK>(bank);
+
+        if( !delta )
+        {
+            // Values and validity flags
+            if( !available(count, 2) )
+                return false;
+
+            block.values.resize(count);
+            block.valid.resize(count);
+            if( !get(block.values.data(), count) || !get(block.valid.data(), count) )
+                return false;
+        }
+        else
+        {
+            // ----> Apply the changes to the base snapshot
+            const RegisterBlock* base_block = base?base->findBlock(block.bank, block.side, block.address):nullptr;
+            if( !base_block || base_block->values.size()!=count )
+                return false;
+
+            uint32_t changes = 0;
+            if( !get(&changes, 4) || changes>count || !available(changes, REG_DUMP_CHANGE_SIZE) )
+                return false;
+
+            block.values = base_block->values;
+            block.valid = base_block->valid;
+
+            for( uint32_t c=0; c<changes; c++ )
+            {
+                uint32_t offset = 0;
+                uint8_t value = 0, valid = 0;
+                if( !get(&offset, 4) || !get(&value, 1) || !get(&valid, 1) || offset>=count )
+                    return false;
+                block.values[offset] = value;
+                block.valid[offset] = valid;
+            }
+            // <---- Apply the changes to the base snapshot
+        }
+
+        snap.blocks.push_back(std::move(block));
+    }
+
+    return true;
+}
+
+}
+
+}
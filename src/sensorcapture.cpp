@@ -19,6 +19,7 @@
 ///////////////////////////////////////////////////////////////////////////
 
 #include "sensorcapture.hpp"
+#include "trace.hpp"
 
 #ifdef VIDEO_MOD_AVAILABLE
 
@@ -33,9 +34,10 @@ namespace sl_oc {
 
 namespace sensors {
 
-SensorCapture::SensorCapture(VERBOSITY verbose_lvl )
+SensorCapture::SensorCapture(VERBOSITY verbose_lvl, const ThreadConfig& thread_cfg )
 {
     mVerbose = verbose_lvl;
+    mThreadCfg = thread_cfg;
 
     if( mVerbose )
     {
@@ -50,6 +52,7 @@ SensorCapture::SensorCapture(VERBOSITY verbose_lvl )
 
 SensorCapture::~SensorCapture()
 {
+    stopStatsDump();
     close();
 }
 
@@ -308,6 +311,12 @@ void SensorCapture::grabThreadFunc()
     mStopCapture = false;
     mGrabRunning = false;
 
+    std::string cfg_err;
+    if( !applyThreadConfig(mThreadCfg, cfg_err) )
+    {
+        WARNING_OUT(mVerbose,cfg_err);
+    }
+
     mNewIMUData=false;
     mNewMagData=false;
     mNewEnvData=false;
@@ -325,6 +334,8 @@ void SensorCapture::grabThreadFunc()
     mSysTsQueue.reserve(TS_SHIFT_VAL_COUNT);
     mMcuTsQueue.reserve(TS_SHIFT_VAL_COUNT);
 
+    uint64_t last_recv_ts = 0;
+
     while (!mStopCapture)
     {
         // ----> Keep data stream alive
@@ -341,15 +352,32 @@ void SensorCapture::grabThreadFunc()
 
         // Sensor data request
         usbBuf[1]=usb::REP_ID_SENSOR_DATA;
+        uint64_t read_ts = getSteadyTimestamp();
         int res = hid_read_timeout( mDevHandle, usbBuf, 64, 2000 );
+        uint64_t recv_ts = getSteadyTimestamp();
+        TRACE_INSTANT("hid_report_read", res);
 
         // ----> Data received?
         if( res < static_cast<int>(sizeof(usb::RawData)) )  {
+            mReadErrors++;
             hid_set_nonblocking( mDevHandle, 0 );
             continue;
         }
         // <---- Data received?
 
+        // ----> Metrics
+        mHidReadTime.add(recv_ts-read_ts);
+        if( last_recv_ts!=0 )
+        {
+            uint64_t interval = recv_ts-last_recv_ts;
+            mSampleInterval.add(interval);
+            uint64_t avg = mSampleIntervalAvg.load(std::memory_order_relaxed);
+            mSampleIntervalAvg.store(avg==0?interval:(avg*15+interval)/16, std::memory_order_relaxed);
+        }
+        last_recv_ts = recv_ts;
+        mSampleCount++;
+        // <---- Metrics
+
         // ----> Received data are correct?
         int target_struct_id = 0;
         if (mDevPid==SL_USB_PROD_MCU_ZED2_REVA || mDevPid==SL_USB_PROD_MCU_ZED2i_REVA)
@@ -362,6 +390,8 @@ void SensorCapture::grabThreadFunc()
                 WARNING_OUT(mVerbose,std::string("REP_ID_SENSOR_DATA - Sensor Data type mismatch") );
             }
 
+            mReadErrors++;
+
             hid_set_nonblocking( mDevHandle, 0 );
             continue;
         }
@@ -431,6 +461,8 @@ void SensorCapture::grabThreadFunc()
 
                     //Adjust scaling continuoulsy. No jump so that ts(n) - ts(n-1) == 400Hz
                     mNTPTsScaling*=scale;
+                    TRACE_INSTANT("timestamp_scaling_update", static_cast<int64_t>(mNTPTsScaling*1e9));
+                    mTsScalingStat = mNTPTsScaling;
 
                     //scale will be applied to the next values, so clear the vector and wait until we have enough data again
                     mMcuTsQueue.clear();
@@ -570,7 +602,9 @@ void SensorCapture::updateTimestampOffset( uint64_t frame_ts)
     if(count==3)
     {
         int64_t offset = offset_sum/count;
+        TRACE_INSTANT("timestamp_offset_update", offset);
         mSyncOffset += offset;
+        mSyncOffsetStat = mSyncOffset;
 #if 0
         std::cout << "Offset: " << offset << std::endl;
         std::cout << "mSyncOffset: " << mSyncOffset << std::endl;
@@ -873,6 +907,51 @@ const data::Temperature& SensorCapture::getLastCameraTemperatureData(uint64_t ti
     return mLastCamTempData;
 }
 
+SensorStats SensorCapture::getStats()
+{
+    SensorStats stats;
+
+    uint64_t interval = mSampleIntervalAvg.load(std::memory_order_relaxed);
+    stats.sample_rate = interval?1e9/static_cast<double>(interval):0.0;
+    stats.sample_count = mSampleCount.load(std::memory_order_relaxed);
+    stats.read_errors = mReadErrors.load(std::memory_order_relaxed);
+
+    stats.hid_read_time = mHidReadTime.snapshot();
+    stats.sample_interval = mSampleInterval.snapshot();
+
+    stats.ts_scaling = mTsScalingStat.load();
+    stats.sync_offset = mSyncOffsetStat.load();
+
+    return stats;
+}
+
+std::string SensorCapture::getStatsText()
+{
+    SensorStats stats = getStats();
+    std::string labels = "serial=\"" + std::to_string(mDevSerial) + "\"";
+
+    std::ostringstream out;
+    writePrometheusValue(out, "zed_oc_sensors_sample_rate", "gauge", labels, stats.sample_rate, "Rate of the received sensor data");
+    writePrometheusValue(out, "zed_oc_sensors_samples_total", "counter", labels, stats.sample_count, "Received sensor data");
+    writePrometheusValue(out, "zed_oc_sensors_read_errors_total", "counter", labels, stats.read_errors, "Failed or invalid HID reads");
+    writePrometheusSummary(out, "zed_oc_sensors_hid_read_seconds", labels, stats.hid_read_time, 1e-9, "Duration of the HID reads returning sensor data");
+    writePrometheusSummary(out, "zed_oc_sensors_sample_interval_seconds", labels, stats.sample_interval, 1e-9, "Host time interval between consecutive sensor data");
+    writePrometheusValue(out, "zed_oc_sensors_ts_scaling", "gauge", labels, stats.ts_scaling, "Timestamp drift scaling factor");
+    writePrometheusValue(out, "zed_oc_sensors_sync_offset_seconds", "gauge", labels, static_cast<double>(stats.sync_offset)*1e-9, "Timestamp offset respect to the synchronized camera");
+
+    return out.str();
+}
+
+void SensorCapture::startStatsDump( const std::string& path, uint32_t period_msec )
+{
+    mStatsDumper.start(path, period_msec, [this]{return getStatsText();});
+}
+
+void SensorCapture::stopStatsDump()
+{
+    mStatsDumper.stop();
+}
+
 }
 
 }
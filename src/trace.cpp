@@ -0,0 +1,174 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+#include "trace.hpp"
+
+#ifdef TRACE_EVENTS_AVAILABLE
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <fstream>
+#include <iomanip>
+#include <algorithm>
+
+#include <pthread.h>
+#include <unistd.h>           // for getpid
+#include <sys/syscall.h>      // for SYS_gettid
+
+namespace sl_oc {
+
+namespace trace {
+
+/*!
+ * \brief A recorded trace event
+ */
+struct Event
+{
+    const char* name;
+    uint64_t ts;        // Steady clock timestamp [nsec]
+    int64_t arg;
+    char phase;
+};
+
+/*!
+ * \brief The events recorded by a thread. Only the owner thread writes, so no lock is required
+ */
+struct ThreadBuffer
+{
+    std::vector<Event> events;
+    std::atomic<size_t> count{0};   // Number of valid events, published with release semantic
+    uint32_t generation = 0;        // Recording session of the buffer
+    long tid = 0;
+    std::string thread_name;
+};
+
+static std::atomic<bool> gEnabled{false};          // Indicates if the events are recorded
+static std::atomic<uint32_t> gGeneration{0};       // Incremented by each `start` to discard the old buffers
+static std::atomic<size_t> gEventsPerThread{TRACE_DEFAULT_EVENTS_PER_THREAD};
+
+static std::mutex gRegistryMutex;                  // Protects `gRegistry`, locked only when a thread creates its buffer
+static std::vector<std::shared_ptr<ThreadBuffer>> gRegistry;
+
+static thread_local std::shared_ptr<ThreadBuffer> tBuffer;
+
+void start( size_t events_per_thread )
+{
+    const std::lock_guard<std::mutex> lock(gRegistryMutex);
+    gRegistry.clear();
+    gEventsPerThread = std::max<size_t>(1, events_per_thread);
+    gGeneration++;
+    gEnabled = true;
+}
+
+void stop()
+{
+    gEnabled = false;
+}
+
+void record( const char* name, char phase, int64_t arg )
+{
+    if( !gEnabled.load(std::memory_order_relaxed) )
+        return;
+
+    uint32_t generation = gGeneration.load(std::memory_order_relaxed);
+
+    // ----> Create the thread buffer for the current recording session
+    if( !tBuffer || tBuffer->generation!=generation )
+    {
+        std::shared_ptr<ThreadBuffer> buffer = std::make_shared<ThreadBuffer>();
+        buffer->events.resize(gEventsPerThread);
+        buffer->generation = generation;
+        buffer->tid = syscall(SYS_gettid);
+
+        char thread_name[16] = {0};
+        pthread_getname_np(pthread_self(), thread_name, sizeof(thread_name));
+        buffer->thread_name = thread_name;
+
+        const std::lock_guard<std::mutex> lock(gRegistryMutex);
+        gRegistry.push_back(buffer);
+        tBuffer = buffer;
+    }
+    // <---- Create the thread buffer for the current recording session
+
+    size_t idx = tBuffer->count.load(std::memory_order_relaxed);
+    if( idx>=tBuffer->events.size() )
+        return;
+
+    Event& evt = tBuffer->events[idx];
+    evt.name = name;
+    evt.ts = getSteadyTimestamp();
+    evt.arg = arg;
+    evt.phase = phase;
+
+    tBuffer->count.store(idx+1, std::memory_order_release);
+}
+
+bool write( const std::string& path )
+{
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+    {
+        const std::lock_guard<std::mutex> lock(gRegistryMutex);
+        buffers = gRegistry;
+    }
+
+    std::ofstream file(path, std::ios::trunc);
+    if( !file.is_open() )
+        return false;
+
+    pid_t pid = getpid();
+    bool first = true;
+
+    file << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+    file << std::fixed << std::setprecision(3);
+
+    for( const std::shared_ptr<ThreadBuffer>& buffer : buffers )
+    {
+        // ----> Thread name metadata
+        file << (first?"\n":",\n");
+        first = false;
+        file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" << pid << ",\"tid\":" << buffer->tid
+             << ",\"args\":{\"name\":\"" << buffer->thread_name << "\"}}";
+        // <---- Thread name metadata
+
+        size_t count = buffer->count.load(std::memory_order_acquire);
+        for( size_t i=0; i<count; i++ )
+        {
+            const Event& evt = buffer->events[i];
+            file << ",\n{\"name\":\"" << evt.name << "\",\"ph\":\"" << evt.phase << "\",\"ts\":"
+                 << static_cast<double>(evt.ts)/1e3 << ",\"pid\":" << pid << ",\"tid\":" << buffer->tid;
+            if( evt.phase=='i' )
+                file << ",\"s\":\"t\"";
+            if( evt.phase!='E' )
+                file << ",\"args\":{\"value\":" << evt.arg << "}";
+            file << "}";
+        }
+    }
+
+    file << "\n]}\n";
+
+    return file.good();
+}
+
+}
+
+}
+
+#endif // TRACE_EVENTS_AVAILABLE
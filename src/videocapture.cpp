@@ -19,6 +19,7 @@
 ///////////////////////////////////////////////////////////////////////////
 
 #include "videocapture.hpp"
+#include "trace.hpp"
 
 #ifdef SENSORS_MOD_AVAILABLE
 #include "sensorcapture.hpp"
@@ -34,14 +35,21 @@
 #include <linux/videodev2.h>  // for v4l2_buffer, v4l2_queryctrl, V4L2_BUF_T...
 #include <sys/mman.h>         // for mmap, munmap, MAP_SHARED, PROT_READ
 #include <sys/ioctl.h>        // for ioctl
+#include <sys/eventfd.h>      // for eventfd
+#include <poll.h>             // for poll, pollfd, POLLIN
+#include <sys/resource.h>     // for setpriority
+#include <sys/syscall.h>      // for SYS_gettid
 
 #include <sstream>
 #include <fstream>            // for char_traits, basic_istream::operator>>
 
 #include <cmath>              // for round
+#include <algorithm>          // for min, max
 
 #define IOCTL_RETRY 3
 
+#define GRAB_POLL_TIMEOUT_MSEC 2000
+
 #define READ_MODE   1
 #define WRITE_MODE  2
 
@@ -62,6 +70,9 @@
 #define ADDR_GAIN_M  0x3508
 #define ADDR_GAIN_L  0x3509
 
+#define XU_BURST_READ_OFFSET    17  // Offset of the register values in the XU buffer returned by a read command
+#define XU_BURST_WRITE_OFFSET   16  // Offset of the register values in the XU buffer of a write command
+
 #define XU_TASK_SET     0x50
 #define XU_TASK_GET     0x51
 #define XU_ISP_CTRL     0x07
@@ -112,9 +123,249 @@ namespace sl_oc {
 
 namespace video {
 
+/*!
+ * \brief Default allocator of the UVC buffers in USERPTR mode: page aligned memory
+ */
+class PageAlignedAllocator : public FrameAllocator
+{
+public:
+    void* allocate( size_t size ) override
+    {
+        void* ptr = nullptr;
+        if( posix_memalign(&ptr, sysconf(_SC_PAGESIZE), size)!=0 )
+            return nullptr;
+        return ptr;
+    }
+
+    void deallocate( void* ptr, size_t size ) override
+    {
+        (void)size;
+        free(ptr);
+    }
+};
+
+static PageAlignedAllocator defaultAllocator;
+
+/*!
+ * \brief Get the current time of a system clock
+ * \param clk the clock to be read
+ * \return the current time in nanoseconds
+ */
+static uint64_t getClockTimestamp( clockid_t clk )
+{
+    struct timespec ts;
+    clock_gettime(clk, &ts);
+    return static_cast<uint64_t>(ts.tv_sec)*NSEC_PER_SEC + ts.tv_nsec;
+}
+
+/*!
+ * \brief A registered frame callback with its worker threads and its statistics
+ */
+struct FrameCallbackSlot
+{
+    FrameCallback callback;
+    CALLBACK_MODE mode = CALLBACK_MODE::INLINE;
+    size_t queue_size = 0;
+
+    std::mutex mutex;               // Protects `queue`, `stop` and `stats`
+    std::condition_variable cv;     // Signaled when a frame is enqueued or the workers must stop
+    std::deque<FramePtr> queue;     // Frames waiting for a worker, oldest first
+    bool stop = false;
+    std::vector<std::thread> workers;
+
+    CallbackStats stats;
+
+    // Call the callback measuring its execution time
+    void run( const FramePtr& frame )
+    {
+        uint64_t start = getSteadyTimestamp();
+        callback(frame);
+        uint64_t elapsed = getSteadyTimestamp()-start;
+
+        const std::lock_guard<std::mutex> lock(mutex);
+        stats.calls++;
+        stats.total_nsec += elapsed;
+        stats.last_nsec = elapsed;
+        if( stats.calls==1 || elapsed<stats.min_nsec )
+            stats.min_nsec = elapsed;
+        if( elapsed>stats.max_nsec )
+            stats.max_nsec = elapsed;
+    }
+
+    // Enqueue a frame for the workers, skipping the oldest one if the queue is full
+    void push( const FramePtr& frame )
+    {
+        FramePtr skipped; // Released after unlocking, it can hold a UVC buffer lease
+
+        std::unique_lock<std::mutex> lock(mutex);
+        if( queue.size()>=queue_size )
+        {
+            skipped = std::move(queue.front());
+            queue.pop_front();
+            stats.skipped++;
+        }
+        queue.push_back(frame);
+        lock.unlock();
+
+        cv.notify_one();
+    }
+
+    // Worker thread function
+    void work()
+    {
+        while(1)
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            cv.wait(lock, [this]{return stop || !queue.empty();});
+            if( stop )
+                return;
+
+            FramePtr frame = std::move(queue.front());
+            queue.pop_front();
+            lock.unlock();
+
+            run(frame);
+        }
+    }
+
+    // Stop the workers, waiting for the running calls to complete
+    void shutdown()
+    {
+        std::deque<FramePtr> pending;
+
+        std::unique_lock<std::mutex> lock(mutex);
+        stop = true;
+        pending.swap(queue);
+        lock.unlock();
+
+        cv.notify_all();
+        for( std::thread& worker : workers )
+        {
+            if( worker.joinable() )
+                worker.join();
+        }
+        workers.clear();
+    }
+};
+
+// Keys of the asynchronous camera settings commands: a command replaces the pending command with the same key
+enum CONTROL_KEY {
+    CTRL_KEY_LED,
+    CTRL_KEY_BRIGHTNESS,
+    CTRL_KEY_SHARPNESS,
+    CTRL_KEY_CONTRAST,
+    CTRL_KEY_HUE,
+    CTRL_KEY_SATURATION,
+    CTRL_KEY_WHITE_BALANCE,     // Shared by manual and automatic white balance: the last command wins
+    CTRL_KEY_GAMMA,
+    CTRL_KEY_AECAGC,
+    CTRL_KEY_ROI,
+    CTRL_KEY_GAIN,
+    CTRL_KEY_EXPOSURE
+};
+
+// Key of a command applied to one of the sensors
+static inline uint32_t controlKey( CONTROL_KEY ctrl, int side=0 ) {return (static_cast<uint32_t>(ctrl)<<8) | static_cast<uint32_t>(side&0xFF);}
+
+/*!
+ * \brief The ControlQueue struct executes the asynchronous camera settings commands on a dedicated thread
+ */
+struct ControlQueue
+{
+    struct Command
+    {
+        uint32_t key;
+        std::function<bool()> command;
+        std::vector<std::promise<bool>> promises;   // The promises of the replaced commands are set with the result of the newest
+    };
+
+    std::mutex mutex;               // Protects `queue` and `stop`
+    std::condition_variable cv;     // Signaled when a command is enqueued or the thread must stop
+    std::deque<Command> queue;      // Pending commands, oldest first, at most one for each key
+    bool stop = false;
+    std::thread thread;
+
+    ~ControlQueue() {shutdown();}
+
+    // Enqueue a command, replacing the pending command with the same key
+    std::future<bool> push( uint32_t key, std::function<bool()> command )
+    {
+        std::promise<bool> promise;
+        std::future<bool> result = promise.get_future();
+
+        std::unique_lock<std::mutex> lock(mutex);
+        if( stop )
+        {
+            promise.set_value(false);
+            return result;
+        }
+
+        Command cmd;
+        cmd.key = key;
+        cmd.command = std::move(command);
+
+        auto it = std::find_if(queue.begin(), queue.end(), [key](const Command& c){return c.key==key;});
+        if( it!=queue.end() )
+        {
+            // Moved to the end, so the commands are executed in the order of their last update
+            cmd.promises = std::move(it->promises);
+            queue.erase(it);
+        }
+        cmd.promises.push_back(std::move(promise));
+        queue.push_back(std::move(cmd));
+        lock.unlock();
+
+        cv.notify_one();
+        return result;
+    }
+
+    // Control thread function
+    void work()
+    {
+        pthread_setname_np(pthread_self(), "zed_oc_control");
+
+        while(1)
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            cv.wait(lock, [this]{return stop || !queue.empty();});
+            if( stop )
+                return;
+
+            Command cmd = std::move(queue.front());
+            queue.pop_front();
+            lock.unlock();
+
+            bool ok = cmd.command();
+            for( std::promise<bool>& promise : cmd.promises )
+                promise.set_value(ok);
+        }
+    }
+
+    // Stop the thread, waiting for the running command to complete. The pending commands fail
+    void shutdown()
+    {
+        std::deque<Command> pending;
+
+        std::unique_lock<std::mutex> lock(mutex);
+        stop = true;
+        pending.swap(queue);
+        lock.unlock();
+
+        cv.notify_all();
+        if( thread.joinable() )
+            thread.join();
+
+        for( Command& cmd : pending )
+        {
+            for( std::promise<bool>& promise : cmd.promises )
+                promise.set_value(false);
+        }
+    }
+};
+
 VideoCapture::VideoCapture(VideoParams params)
 {
-    memcpy( &mParams, &params, sizeof(VideoParams) );
+    mParams = params;
 
     if( mParams.verbose )
     {
@@ -129,6 +380,52 @@ VideoCapture::VideoCapture(VideoParams params)
     // Check that FPS is coherent with user resolution
     checkResFps( );
 
+    // Check that the number of UVC buffers is in the valid range
+    if( mParams.buffer_count<MIN_UVC_BUFFERS || mParams.buffer_count>MAX_UVC_BUFFERS )
+    {
+        WARNING_OUT(mParams.verbose,"UVC buffer count not in the range [" + std::to_string(MIN_UVC_BUFFERS) + "," +
+                    std::to_string(MAX_UVC_BUFFERS) + "]. Using the nearest valid value");
+        mParams.buffer_count = std::max(MIN_UVC_BUFFERS, std::min(MAX_UVC_BUFFERS, mParams.buffer_count));
+    }
+
+    // Check that the size of the frame pool is in the valid range
+    if( mParams.frame_pool_size<MIN_FRAME_POOL_SIZE || mParams.frame_pool_size>MAX_FRAME_POOL_SIZE )
+    {
+        WARNING_OUT(mParams.verbose,"Frame pool size not in the range [" + std::to_string(MIN_FRAME_POOL_SIZE) + "," +
+                    std::to_string(MAX_FRAME_POOL_SIZE) + "]. Using the nearest valid value");
+        mParams.frame_pool_size = std::max(MIN_FRAME_POOL_SIZE, std::min(MAX_FRAME_POOL_SIZE, mParams.frame_pool_size));
+    }
+
+    // Check that the size of the frame ring is in the valid range
+    if( mParams.frame_ring_size<MIN_FRAME_RING_SIZE || mParams.frame_ring_size>MAX_FRAME_RING_SIZE )
+    {
+        WARNING_OUT(mParams.verbose,"Frame ring size not in the range [" + std::to_string(MIN_FRAME_RING_SIZE) + "," +
+                    std::to_string(MAX_FRAME_RING_SIZE) + "]. Using the nearest valid value");
+        mParams.frame_ring_size = std::max(MIN_FRAME_RING_SIZE, std::min(MAX_FRAME_RING_SIZE, mParams.frame_ring_size));
+    }
+
+    if( mParams.export_dmabuf && !mParams.zero_copy )
+    {
+        WARNING_OUT(mParams.verbose,"DMABUF export requires `VideoParams::zero_copy` to be enabled. Export disabled");
+        mParams.export_dmabuf = false;
+    }
+
+    if( mParams.memory==MEMORY_MODE::USERPTR )
+    {
+        mBufMemory = V4L2_MEMORY_USERPTR;
+        mAllocator = mParams.allocator?mParams.allocator:&defaultAllocator;
+
+        if( mParams.export_dmabuf )
+        {
+            WARNING_OUT(mParams.verbose,"DMABUF export is not available in USERPTR mode. Export disabled");
+            mParams.export_dmabuf = false;
+        }
+    }
+    else
+    {
+        mBufMemory = V4L2_MEMORY_MMAP;
+    }
+
     // Calculate gain zones (required because the raw gain control is not continuous in the range of values)
     mGainSegMax = (GAIN_ZONE4_MAX-GAIN_ZONE4_MIN)+(GAIN_ZONE3_MAX-GAIN_ZONE3_MIN)+(GAIN_ZONE2_MAX-GAIN_ZONE2_MIN)+(GAIN_ZONE1_MAX-GAIN_ZONE1_MIN);
 
@@ -141,18 +438,53 @@ VideoCapture::VideoCapture(VideoParams params)
         mExpoureRawMax = EXP_RAW_MAX_60FPS;
     else
         mExpoureRawMax = EXP_RAW_MAX_100FPS;
+
+    mFrameEventFd = eventfd(0, EFD_NONBLOCK|EFD_CLOEXEC);
+    if( mFrameEventFd==-1 )
+    {
+        std::string msg = std::string("Cannot create the frame event file descriptor: [")
+                + std::to_string(errno) + std::string("] ") + std::string(strerror(errno));
+        WARNING_OUT(mParams.verbose,msg);
+    }
+
+    mWakeEventFd = eventfd(0, EFD_NONBLOCK|EFD_CLOEXEC);
+    if( mWakeEventFd==-1 )
+    {
+        std::string msg = std::string("Cannot create the wake-up event file descriptor: [")
+                + std::to_string(errno) + std::string("] ") + std::string(strerror(errno));
+        ERROR_OUT(mParams.verbose,msg);
+    }
 }
 
 VideoCapture::~VideoCapture()
 {
+    stopStatsDump();
     reset();
+
+    if( mFrameEventFd!=-1 )
+    {
+        close(mFrameEventFd);
+        mFrameEventFd=-1;
+    }
+
+    if( mWakeEventFd!=-1 )
+    {
+        close(mWakeEventFd);
+        mWakeEventFd=-1;
+    }
 }
 
 void VideoCapture::reset()
 {
+    stopControlQueue();
+
+#ifdef SENSOR_LOG_AVAILABLE
+    enableAecAgcSensLogging(false);
+#endif
+
     setLEDstatus( false );
 
-    mStopCapture = true;
+    stopCapture();
 
     if( mGrabThread.joinable() )
     {
@@ -166,15 +498,28 @@ void VideoCapture::reset()
     // <---- Stop capturing
 
     // ----> deinit device
-    if( mInitialized && mBuffers)
-    {
-        for (unsigned int i = 0; i < mBufCount; ++i)
-            munmap(mBuffers[i].start, mBuffers[i].length);
-        if (mBuffers)
-            free(mBuffers);
-
-        mBuffers = nullptr;
-    }
+    removeAllFrameCallbacks();
+    releaseAllExportedFrames();
+
+    mBufMutex.lock();
+    mReadyBufs.clear();
+    mBufLeases.clear();
+    mBufFrames.clear();
+    mFrameStats = FrameStats();
+    mPublishLatency.reset();
+    mDqbufWait.reset();
+    mMemcpyTime.reset();
+    mComMutexWait.reset();
+    mComMutexHold.reset();
+    mQueueMutexWait.reset();
+    mQueueMutexHold.reset();
+    mFrameIntervalAvg = 0;
+    mReceivedFrames = 0;
+    mLastSequence = -1;
+    mBufMutex.unlock();
+
+    // Also the buffers of a camera that failed to start
+    releaseBuffers();
     // <---- deinit device
 
     if (mFileDesc)
@@ -189,15 +534,69 @@ void VideoCapture::reset()
         mLastFrame.data = nullptr;
     }
 
+    // The frames still held by the application are released with their last handle
+    std::atomic_store(&mPublishedFrame, std::shared_ptr<Frame>());
+    mLastFramePin.reset();
+    mRingSize = 0;
+    mRingSlots.reset();
+    mPoolVersions.reset();
+    mFramePool.clear();
+
     if( mParams.verbose && mInitialized)
     {
         std::string msg = "Device closed";
         INFO_OUT(mParams.verbose,msg );
     }
 
+    mIdentity = CameraIdentity();
+
+    mControlsMutex.lock();
+    mControls.clear();
+    mXuShadow = XuShadow();
+    mControlsMutex.unlock();
+
+    mXuLen = 0;
+    mXuPoll.reset();
+    mXuSafePoll.reset();
+
     mInitialized=false;
 }
 
+void VideoCapture::releaseBuffers()
+{
+    if( !mBuffers )
+        return;
+
+    if( mBufMemory==V4L2_MEMORY_USERPTR && mFileDesc!=-1 )
+    {
+        // Make the driver release the user memory before freeing it
+        struct v4l2_requestbuffers req;
+        memset(&req, 0, sizeof (v4l2_requestbuffers));
+        req.count = 0;
+        req.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        req.memory = V4L2_MEMORY_USERPTR;
+        xioctl(mFileDesc, VIDIOC_REQBUFS, &req);
+    }
+
+    // The buffers not allocated yet when the initialization failed have a null start
+    for (unsigned int i = 0; i < mBufCount; ++i)
+    {
+        if (mBuffers[i].dmabuf_fd != -1)
+            close(mBuffers[i].dmabuf_fd);
+
+        if( mBuffers[i].start==nullptr || mBuffers[i].start==MAP_FAILED )
+            continue;
+
+        if( mBufMemory==V4L2_MEMORY_USERPTR )
+            mAllocator->deallocate(mBuffers[i].start, mBuffers[i].length);
+        else
+            munmap(mBuffers[i].start, mBuffers[i].length);
+    }
+
+    free(mBuffers);
+    mBuffers = nullptr;
+}
+
 void VideoCapture::checkResFps()
 {
     mWidth = cameraResolution[static_cast<int>(mParams.res)].width*2;
@@ -274,6 +673,11 @@ void VideoCapture::checkResFps()
 }
 
 bool VideoCapture::initializeVideo( int devId/*=-1*/ )
+{
+    return initializeVideo( CameraProfile(), devId );
+}
+
+bool VideoCapture::initializeVideo( const CameraProfile& profile, int devId/*=-1*/ )
 {
     reset();
 
@@ -281,12 +685,23 @@ bool VideoCapture::initializeVideo( int devId/*=-1*/ )
 
     if( devId==-1 )
     {
-        // Try to open all the devices until the first success (max allowed by v4l: 64)
-        for( uint8_t id=0; id<64; id++ )
+        // Open the first camera found in sysfs, without probing the other video devices
+        std::vector<CameraDescriptor> cameras = discoverCameras();
+        for( const CameraDescriptor& cam : cameras )
         {
-            opened = openCamera( id );
+            opened = openCamera( static_cast<uint8_t>(cam.video_id) );
             if(opened) break;
         }
+
+        if( cameras.empty() )
+        {
+            // Sysfs not available: try to open all the devices until the first success (max allowed by v4l: 64)
+            for( uint8_t id=0; id<64; id++ )
+            {
+                opened = openCamera( id );
+                if(opened) break;
+            }
+        }
     }
     else
     {
@@ -298,6 +713,11 @@ bool VideoCapture::initializeVideo( int devId/*=-1*/ )
         return false;
     }
 
+    return startOpenedCamera( profile );
+}
+
+bool VideoCapture::startOpenedCamera( const CameraProfile& profile )
+{
     mInitialized = startCapture();
 
     if( mParams.verbose && mInitialized)
@@ -306,20 +726,54 @@ bool VideoCapture::initializeVideo( int devId/*=-1*/ )
         INFO_OUT(mParams.verbose,msg );
     }
 
+    if( mInitialized )
+    {
+        const std::lock_guard<std::mutex> lock(mControlQueueMutex);
+        mControlQueueOpen = true;
+    }
+
     setLEDstatus( true );
 
-    resetAECAGC();
-    resetAutoWhiteBalance();
-    resetBrightness();
-    resetContrast();
-    resetGamma();
-    resetHue();
-    resetSaturation();
-    resetSharpness();
+    if( mInitialized && !applyProfile( profile ) )
+    {
+        std::string msg = "Not all the camera profile settings have been applied";
+        WARNING_OUT(mParams.verbose,msg);
+    }
 
     return mInitialized;
 }
 
+bool VideoCapture::initializeVideo( const CameraDescriptor& desc )
+{
+    if( desc.video_id<0 || desc.video_id>=64 )
+    {
+        std::string msg = "Invalid camera descriptor";
+        ERROR_OUT(mParams.verbose,msg);
+        return false;
+    }
+
+    reset();
+
+    if( !openCamera( static_cast<uint8_t>(desc.video_id) ) )
+    {
+        return false;
+    }
+
+    // The video device can be renumbered if the camera has been plugged again after the discovery
+    bool sn_changed = desc.serial_number!=-1 && desc.serial_number!=mIdentity.serial_number;
+    bool port_changed = !desc.usb_path.empty() && !mIdentity.usb_path.empty() && desc.usb_path!=mIdentity.usb_path;
+    if( sn_changed || port_changed )
+    {
+        std::string msg = "The device '" + mDevName + "' is not the described camera (SN: " +
+                std::to_string(desc.serial_number) + ", USB port: " + desc.usb_path + ")";
+        ERROR_OUT(mParams.verbose,msg);
+        reset();
+        return false;
+    }
+
+    return startOpenedCamera( CameraProfile() );
+}
+
 bool VideoCapture::openCamera( uint8_t devId )
 {
     mDevId = devId;
@@ -399,12 +853,33 @@ bool VideoCapture::openCamera( uint8_t devId )
     }
     // <---- Open
 
-    int sn = getSerialNumber();
+    loadCameraControls();
+
+    // ----> Identity
+    mIdentity = CameraIdentity();
+    mIdentity.model = mCameraModel;
+
+    CameraDescriptor desc;
+    if( describeVideoDevice(devId, desc) )
+    {
+        mIdentity.fw_version = desc.fw_version;
+        mIdentity.usb_path = desc.usb_path;
+        mIdentity.usb_bus = desc.usb_bus;
+        mIdentity.usb_dev = desc.usb_dev;
+    }
+
+    if( !loadCachedIdentity() )
+    {
+        mIdentity.serial_number = readSerialNumber();
+        storeCachedIdentity();
+    }
+
     if(mParams.verbose)
     {
-        std::string msg = std::string("Opened camera with SN: ") + std::to_string(sn);
+        std::string msg = std::string("Opened camera with SN: ") + std::to_string(mIdentity.serial_number);
         INFO_OUT(mParams.verbose,msg);
     }
+    // <---- Identity
 
     // ----> Init
     struct v4l2_capability cap;
@@ -484,16 +959,46 @@ bool VideoCapture::openCamera( uint8_t devId )
     mLastFrame.height = mHeight;
     mLastFrame.channels = mChannels;
     int bufSize = mLastFrame.width * mLastFrame.height * mLastFrame.channels;
-    mLastFrame.data = new unsigned char[bufSize];
+
+    if( mParams.zero_copy )
+    {
+        mLastFrame.data = new unsigned char[bufSize];
+    }
+    else
+    {
+        // All the frame buffers are allocated here: no allocation is performed while grabbing
+        int poolSize = mParams.frame_pool_size + mParams.frame_ring_size - 1;
+        mFramePool.clear();
+        mPoolVersions.reset(new std::atomic<uint64_t>[poolSize]);
+        for( int i=0; i<poolSize; i++ )
+        {
+            mPoolVersions[i] = 0;
+
+            std::shared_ptr<Frame> frame(new Frame, [](Frame* f){ delete [] f->data; delete f; });
+            frame->width = mWidth;
+            frame->height = mHeight;
+            frame->channels = mChannels;
+            frame->data = new unsigned char[bufSize];
+            mFramePool.push_back(frame);
+        }
+
+        mRingSlots.reset(new std::atomic<uint64_t>[mParams.frame_ring_size]);
+        for( int i=0; i<mParams.frame_ring_size; i++ )
+        {
+            mRingSlots[i] = 0;
+        }
+        mRingHead = mFrameCount;
+        mRingSize = mParams.frame_ring_size;
+    }
     // <---- Output frame allocation
 
     struct v4l2_requestbuffers req;
     memset(&req, 0, sizeof (v4l2_requestbuffers));
 
-    req.count = mBufCount;
+    req.count = mParams.buffer_count;
 
     req.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
-    req.memory = V4L2_MEMORY_MMAP;
+    req.memory = mBufMemory;
     if( -1==xioctl(mFileDesc, VIDIOC_REQBUFS, &req) )
     {
         if(mParams.verbose)
@@ -506,16 +1011,36 @@ bool VideoCapture::openCamera( uint8_t devId )
         return false;
     }
 
-    // Create buffers
+    // Create buffers. On failure the buffers already allocated are released at once, before another device is tried
     mBuffers = (UVCBuffer*) calloc(req.count, sizeof(*mBuffers));
+    mBufCount = req.count;
+    for(unsigned int i = 0; i < req.count; ++i)
+        mBuffers[i].dmabuf_fd = -1;
 
-    for(mBufCount = 0; mBufCount < req.count; ++mBufCount)
+    for(unsigned int i = 0; i < req.count; ++i)
     {
+        // ----> User memory
+        if( mBufMemory==V4L2_MEMORY_USERPTR )
+        {
+            mBuffers[i].length = fmt.fmt.pix.sizeimage;
+            mBuffers[i].start = mAllocator->allocate(fmt.fmt.pix.sizeimage);
+
+            if( mBuffers[i].start==nullptr )
+            {
+                ERROR_OUT(mParams.verbose,"Cannot allocate the user memory for the UVC buffers");
+                releaseBuffers();
+                return false;
+            }
+
+            continue;
+        }
+        // <---- User memory
+
         struct v4l2_buffer buf;
         memset(&buf, 0, sizeof (v4l2_buffer));
         buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
         buf.memory = V4L2_MEMORY_MMAP;
-        buf.index = mBufCount;
+        buf.index = i;
         buf.flags = V4L2_BUF_FLAG_TIMESTAMP_MONOTONIC;
         if( -1==xioctl(mFileDesc, VIDIOC_QUERYBUF, &buf))
         {
@@ -526,20 +1051,69 @@ bool VideoCapture::openCamera( uint8_t devId )
                 ERROR_OUT(mParams.verbose,msg);
             }
 
+            releaseBuffers();
             return false;
         }
 
-        mBuffers[mBufCount].length = buf.length;
+        mBuffers[i].length = buf.length;
 
-        mBuffers[mBufCount].start =
+        mBuffers[i].start =
                 mmap(nullptr /* start anywhere */,
                      buf.length,
                      PROT_READ | PROT_WRITE /* required */,
                      MAP_SHARED /* recommended */,
                      mFileDesc, buf.m.offset);
+
+        if( mBuffers[i].start==MAP_FAILED )
+        {
+            if(mParams.verbose)
+            {
+                std::string msg = std::string("Cannot map buffer for '") + mDevName + "': ["
+                        + std::to_string(errno) +std::string("] ") + std::string(strerror(errno));
+                ERROR_OUT(mParams.verbose,msg);
+            }
+
+            releaseBuffers();
+            return false;
+        }
+
+        // ----> DMABUF export
+        if( mParams.export_dmabuf )
+        {
+            struct v4l2_exportbuffer expbuf;
+            memset(&expbuf, 0, sizeof (v4l2_exportbuffer));
+            expbuf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+            expbuf.index = i;
+            expbuf.flags = O_RDONLY|O_CLOEXEC;
+            if( -1==xioctl(mFileDesc, VIDIOC_EXPBUF, &expbuf) )
+            {
+                if(mParams.verbose)
+                {
+                    std::string msg = std::string("Cannot export buffer as DMABUF for '") + mDevName + "': ["
+                            + std::to_string(errno) +std::string("] ") + std::string(strerror(errno));
+                    ERROR_OUT(mParams.verbose,msg);
+                }
+
+                releaseBuffers();
+                return false;
+            }
+
+            mBuffers[i].dmabuf_fd = expbuf.fd;
+        }
+        // <---- DMABUF export
     }
 
-    mBufCount = req.count;
+    // ----> Frame leasing information
+    mBufLeases.assign(mBufCount, 0);
+    mBufFrames.assign(mBufCount, Frame());
+    for(int i=0; i<mBufCount; i++)
+    {
+        mBufFrames[i].width = mWidth;
+        mBufFrames[i].height = mHeight;
+        mBufFrames[i].channels = mChannels;
+        mBufFrames[i].data = static_cast<uint8_t*>(mBuffers[i].start);
+    }
+    // <---- Frame leasing information
     // <---- Init
 
     return true;
@@ -547,45 +1121,125 @@ bool VideoCapture::openCamera( uint8_t devId )
 
 int VideoCapture::getSerialNumber()
 {
-    /*if(!mInitialized)
-        return -1;*/
-
-    int ulValue = -1;
+    if( mIdentity.serial_number==-1 && mFileDesc>=0 )
+        mIdentity.serial_number = readSerialNumber();
 
-    uint8_t UNIQUE_BUF[384];
-    memset(UNIQUE_BUF, 0, 384);
+    return mIdentity.serial_number;
+}
 
-    int res = -1;
+bool VideoCapture::loadCachedIdentity()
+{
+    if( mParams.identity_cache.empty() || mIdentity.usb_path.empty() )
+        return false;
 
-    int try_count = 0;
-    while(res!=0)
+    std::ifstream file(mParams.identity_cache);
+    std::string line;
+    while( std::getline(file, line) )
     {
-        res = ll_SPI_FlashProgramRead(&UNIQUE_BUF[0], UNIQUE_ID_START, 64, true);
-
-        //check bytes read
-        if (UNIQUE_BUF[0] != 'O') {
-            res =  -1;
-        }
-        if (UNIQUE_BUF[1] != 'V') {
-            res =  -1;
+        std::istringstream ss(line);
+        std::string usb_path;
+        int bus = -1, dev = -1, sn = -1, fw = -1, model = -1;
+        if( !(ss >> usb_path >> bus >> dev >> sn >> fw >> model) || usb_path!=mIdentity.usb_path )
+            continue;
+
+        // The device number changes when the camera is plugged again: the entry can refer to another camera
+        if( bus!=mIdentity.usb_bus || dev!=mIdentity.usb_dev ||
+                fw!=mIdentity.fw_version || model!=static_cast<int>(mIdentity.model) || sn==-1 )
+        {
+            if(mParams.verbose)
+            {
+                std::string msg = "Identity cache entry of USB port " + usb_path + " is outdated";
+                INFO_OUT(mParams.verbose,msg);
+            }
+            return false;
         }
 
-        try_count++;
-        if (try_count>500)
-            break;
-        usleep(1000);
+        mIdentity.serial_number = sn;
+        return true;
     }
 
-    if (res != 0)
-        return -1;
+    return false;
+}
 
-    //check bytes read
-    if (UNIQUE_BUF[0] != 'O') {
-        return -1;
-    }
-    if (UNIQUE_BUF[1] != 'V') {
-        return -1;
-    }
+void VideoCapture::storeCachedIdentity()
+{
+    if( mParams.identity_cache.empty() || mIdentity.usb_path.empty() || mIdentity.serial_number==-1 )
+        return;
+
+    // ----> Keep the entries of the other USB ports
+    std::ostringstream content;
+    {
+        std::ifstream file(mParams.identity_cache);
+        std::string line;
+        while( std::getline(file, line) )
+        {
+            std::istringstream ss(line);
+            std::string usb_path;
+            if( (ss >> usb_path) && usb_path!=mIdentity.usb_path )
+                content << line << "\n";
+        }
+    }
+    // <---- Keep the entries of the other USB ports
+
+    content << mIdentity.usb_path << " " << mIdentity.usb_bus << " " << mIdentity.usb_dev << " "
+            << mIdentity.serial_number << " " << mIdentity.fw_version << " " << static_cast<int>(mIdentity.model) << "\n";
+
+    // Written to a temporary file and renamed, so that other processes never read a partial file
+    std::string tmp_path = mParams.identity_cache + "." + std::to_string(getpid()) + ".tmp";
+    {
+        std::ofstream file(tmp_path, std::ios::trunc);
+        file << content.str();
+    }
+
+    if( std::rename(tmp_path.c_str(), mParams.identity_cache.c_str())!=0 )
+    {
+        std::remove(tmp_path.c_str());
+        if(mParams.verbose)
+        {
+            std::string msg = "Cannot write the identity cache '" + mParams.identity_cache + "'";
+            WARNING_OUT(mParams.verbose,msg);
+        }
+    }
+}
+
+int VideoCapture::readSerialNumber()
+{
+    int ulValue = -1;
+
+    uint8_t UNIQUE_BUF[384];
+    memset(UNIQUE_BUF, 0, 384);
+
+    int res = -1;
+
+    int try_count = 0;
+    while(res!=0)
+    {
+        res = ll_SPI_FlashProgramRead(&UNIQUE_BUF[0], UNIQUE_ID_START, 64, true);
+
+        //check bytes read
+        if (UNIQUE_BUF[0] != 'O') {
+            res =  -1;
+        }
+        if (UNIQUE_BUF[1] != 'V') {
+            res =  -1;
+        }
+
+        try_count++;
+        if (try_count>500)
+            break;
+        usleep(1000);
+    }
+
+    if (res != 0)
+        return -1;
+
+    //check bytes read
+    if (UNIQUE_BUF[0] != 'O') {
+        return -1;
+    }
+    if (UNIQUE_BUF[1] != 'V') {
+        return -1;
+    }
 
     ulValue = (UNIQUE_BUF[2] << 24) + (UNIQUE_BUF[3] << 16) + (UNIQUE_BUF[4] << 8) + UNIQUE_BUF[5];
 
@@ -603,8 +1257,13 @@ bool VideoCapture::startCapture()
     {
         struct v4l2_buffer buf = {0};
         buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
-        buf.memory = V4L2_MEMORY_MMAP;
+        buf.memory = mBufMemory;
         buf.index = i;
+        if( mBufMemory==V4L2_MEMORY_USERPTR )
+        {
+            buf.m.userptr = reinterpret_cast<unsigned long>(mBuffers[i].start);
+            buf.length = mBuffers[i].length;
+        }
         if( -1==xioctl(mFileDesc, VIDIOC_QBUF, &buf) )
         {
             if(mParams.verbose)
@@ -618,6 +1277,7 @@ bool VideoCapture::startCapture()
         }
     }
     type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    mDriverBufs = mBufCount;
 
     // Set priority
     int priority = V4L2_PRIORITY_RECORD;
@@ -647,6 +1307,8 @@ bool VideoCapture::startCapture()
     }
     // <---- Start capturing
 
+    // Set before starting the thread, so that a stop request cannot be lost
+    mStopCapture = false;
     mGrabThread = std::thread( &VideoCapture::grabThreadFunc,this );
 
     return true;
@@ -734,178 +1396,961 @@ SL_DEVICE VideoCapture::getCameraModel( std::string dev_name)
             WARNING_OUT(mParams.verbose,msg);
         }
 
-        return camera_device;
+        return camera_device;
+    }
+
+    // check PID VID
+    if (pid == SL_USB_PROD_ZED_REVA && vid == SL_USB_VENDOR)
+        camera_device = SL_DEVICE::ZED;
+    else if (pid == SL_USB_PROD_ZED_M_REVA && vid == SL_USB_VENDOR)
+        camera_device = SL_DEVICE::ZED_M;
+    else if (pid == SL_USB_PROD_ZED_REVB && vid == SL_USB_VENDOR)
+        camera_device = SL_DEVICE::ZED_CBS;
+    else if (pid == SL_USB_PROD_ZED_M_REVB && vid == SL_USB_VENDOR)
+        camera_device = SL_DEVICE::ZED_M_CBS;
+    else if (pid == SL_USB_PROD_ZED_2_REVB && vid == SL_USB_VENDOR)
+        camera_device = SL_DEVICE::ZED_2;
+    else if (pid == SL_USB_PROD_ZED_2i && vid == SL_USB_VENDOR)
+        camera_device = SL_DEVICE::ZED_2i;
+
+    return camera_device;
+}
+
+void VideoCapture::grabThreadFunc()
+{
+    mNewFrame = false;
+
+    std::string cfg_err;
+    if( !applyThreadConfig(mParams.grab_thread, cfg_err) )
+    {
+        WARNING_OUT(mParams.verbose,cfg_err);
+    }
+
+    if (mFileDesc < 0)
+        return;
+
+    // The wake-up event is the first, so that it can be polled alone when no buffer is queued to the driver
+    struct pollfd fds[2];
+    fds[0].fd = mWakeEventFd;
+    fds[0].events = POLLIN;
+    fds[1].fd = mFileDesc;
+    fds[1].events = POLLIN;
+
+    struct v4l2_buffer buf;
+    memset(&(buf), 0, sizeof (buf));
+    buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    buf.memory = mBufMemory;
+    buf.bytesused = -1;
+    buf.length = 0;
+
+    int capture_frame_count = 0;
+
+    mFirstFrame=true;
+
+    uint64_t last_dq_ts = 0;
+
+    while (!mStopCapture)
+    {
+        mGrabRunning=true;
+
+        // ----> Wait for a frame or for a wake-up event
+        // The driver cannot complete a frame if no buffer is queued: wait for a buffer to be released
+        nfds_t nfds = (mDriverBufs>0)?2:1;
+        uint64_t wait_ts = getSteadyTimestamp();
+        int pret = poll(fds, nfds, GRAB_POLL_TIMEOUT_MSEC);
+
+        if( pret<0 && errno!=EINTR )
+        {
+            if(mParams.verbose)
+            {
+                std::string msg = std::string("Error waiting for a new frame from '") + mDevName + "': ["
+                        + std::to_string(errno) +std::string("] ") + std::string(strerror(errno));
+                ERROR_OUT(mParams.verbose,msg);
+            }
+            break;
+        }
+
+        if( pret<=0 )
+            continue; // Timeout or signal
+
+        if( fds[0].revents & POLLIN )
+        {
+            uint64_t evt;
+            ssize_t res = read(mWakeEventFd, &evt, sizeof(evt));
+            (void)res;
+        }
+
+        if( nfds<2 || fds[1].revents==0 )
+            continue;
+
+        if( fds[1].revents & (POLLERR|POLLHUP|POLLNVAL) )
+        {
+            // Streaming error: avoid a busy loop while the device is not available
+            usleep(1000);
+            continue;
+        }
+        // <---- Wait for a frame or for a wake-up event
+
+        int ret;
+        {
+            TimedLock lock(mQueueMutex, mQueueMutexWait, mQueueMutexHold);
+            ret = ioctl(mFileDesc, VIDIOC_DQBUF, &buf);
+        }
+        uint64_t dq_ts = getSteadyTimestamp();
+
+        if( ret == 0 )
+        {
+            TRACE_INSTANT("frame_dequeued", buf.sequence);
+            mDriverBufs--;
+
+            // ----> Frame rate
+            mDqbufWait.add(dq_ts-wait_ts);
+            if( last_dq_ts!=0 )
+            {
+                uint64_t interval = dq_ts-last_dq_ts;
+                uint64_t avg = mFrameIntervalAvg.load(std::memory_order_relaxed);
+                mFrameIntervalAvg.store(avg==0?interval:(avg*7+interval)/8, std::memory_order_relaxed);
+            }
+            last_dq_ts = dq_ts;
+            mReceivedFrames++;
+            // <---- Frame rate
+
+            // ----> Frames lost by the driver
+            if( mLastSequence>=0 && buf.sequence>mLastSequence+1 )
+            {
+                const std::lock_guard<std::mutex> lock(mBufMutex);
+                mFrameStats.dropped_driver += buf.sequence-mLastSequence-1;
+            }
+            mLastSequence = buf.sequence;
+            // <---- Frames lost by the driver
+        }
+
+        if (buf.bytesused == buf.length && ret == 0 && buf.index < mBufCount)
+        {
+            mCurrentIndex = buf.index;
+
+            // get buffer timestamp in ns
+            uint64_t raw_ts = ((uint64_t) buf.timestamp.tv_sec) * NSEC_PER_SEC + ((uint64_t) buf.timestamp.tv_usec) * 1000;
+
+            if(mFirstFrame)
+            {
+                // The driver timestamps can be mapped to the system clocks only if taken from CLOCK_MONOTONIC,
+                // otherwise they are used as differences from the first frame
+                mMonoTsSrc = ((buf.flags & V4L2_BUF_FLAG_TIMESTAMP_MASK)==V4L2_BUF_FLAG_TIMESTAMP_MONOTONIC);
+                mWallOffset = static_cast<int64_t>(getWallTimestamp()) - static_cast<int64_t>(getClockTimestamp(CLOCK_MONOTONIC));
+                mInitTs = raw_ts;
+                mStartTs = 0; // `mapTimestamp` returns the current time of the selected clock until the start point is set
+                mStartTs = mapTimestamp(raw_ts);
+                //std::cout << "VideoCapture: " << mStartTs << std::endl;
+
+#ifdef SENSORS_MOD_AVAILABLE
+                if(mSyncEnabled && mSensPtr)
+                {
+                    // Synchronize reference timestamp
+                    mSensPtr->setStartTimestamp(mStartTs);
+                }
+#endif
+
+                mFirstFrame = false;
+            }
+
+            uint64_t frame_ts = mapTimestamp(raw_ts);
+
+            FrameLease cbLease; // Lease on the UVC buffer given to the frame callbacks in zero-copy mode
+
+            // ----> Copy the UVC buffer into a free frame of the pool
+            bool published = false;
+            if( !mParams.zero_copy && mBuffers[mCurrentIndex].start != nullptr )
+            {
+                int poolIdx = getFreePoolFrame();
+                if( poolIdx>=0 )
+                {
+                    Frame* frame = mFramePool[poolIdx].get();
+                    size_t frameSize = frame->width * frame->height * frame->channels;
+                    frame->frame_id = ++mFrameCount;
+                    frame->timestamp = frame_ts;
+                    frame->raw_timestamp = raw_ts;
+                    frame->sequence = buf.sequence;
+                    TRACE_SCOPE("frame_copy", frame->frame_id);
+                    uint64_t copy_ts = getSteadyTimestamp();
+                    memcpy(frame->data, (unsigned char*) mBuffers[mCurrentIndex].start,
+                           std::min(frameSize, mBuffers[mCurrentIndex].length));
+                    mMemcpyTime.add(getSteadyTimestamp()-copy_ts);
+
+                    // ----> Publish the frame to the subscribers
+                    mPoolVersions[poolIdx].store(2*frame->frame_id, std::memory_order_release);
+                    mRingSlots[frame->frame_id%mRingSize].store((frame->frame_id<<8)|poolIdx, std::memory_order_release);
+                    mRingHead.store(frame->frame_id, std::memory_order_release);
+                    // <---- Publish the frame to the subscribers
+
+                    std::atomic_store(&mPublishedFrame, mFramePool[poolIdx]);
+                    published = true;
+                }
+            }
+            // <---- Copy the UVC buffer into a free frame of the pool
+
+            mBufMutex.lock();
+            if( mParams.zero_copy )
+            {
+                // ----> Publish the UVC buffer without copying it
+                Frame& frame = mBufFrames[mCurrentIndex];
+                frame.frame_id = ++mFrameCount;
+                frame.timestamp = frame_ts;
+                frame.raw_timestamp = raw_ts;
+                frame.sequence = buf.sequence;
+
+                // The ready queue holds a reference on the buffer, transferred to the first lease
+                mBufLeases[mCurrentIndex] = 1;
+                mReadyBufs.push_back(mCurrentIndex);
+
+                // The frame callbacks hold their own reference
+                if( mCallbackCount>0 )
+                {
+                    mBufLeases[mCurrentIndex]++;
+                    cbLease = FrameLease(this, mCurrentIndex, frame);
+                }
+
+                // ----> Apply the drop policy if no buffer is left to the driver
+                if( mDriverBufs==0 )
+                {
+                    switch( mParams.drop_policy )
+                    {
+                    case DROP_POLICY::DROP_OLDEST:
+                        unrefBuffer(mReadyBufs.front());
+                        mReadyBufs.pop_front();
+                        mFrameStats.dropped_oldest++;
+                        break;
+                    case DROP_POLICY::DROP_NEWEST:
+                        unrefBuffer(mReadyBufs.back());
+                        mReadyBufs.pop_back();
+                        mFrameStats.dropped_newest++;
+                        break;
+                    case DROP_POLICY::BLOCK:
+                        // Buffers are given back to the driver only when released by the application
+                        break;
+                    }
+                }
+                // <---- Apply the drop policy if no buffer is left to the driver
+                // <---- Publish the UVC buffer without copying it
+            }
+            else if( published )
+            {
+                // The previous frame has not been retrieved by getLastFrame/acquireLastFrame
+                if( mNewFrame )
+                    mFrameStats.consumer_overwrite++;
+
+                mNewFrame=true;
+            }
+            else
+            {
+                mFrameStats.dropped_pool++;
+            }
+
+#ifdef SENSORS_MOD_AVAILABLE
+            if(mSensReadyToSync)
+            {
+                mSensReadyToSync = false;
+                TRACE_INSTANT("timestamp_resync", frame_ts);
+                mSensPtr->updateTimestampOffset(frame_ts);
+            }
+#endif
+
+#ifdef SENSOR_LOG_AVAILABLE
+            // ----> AEC/AGC register logging
+            if(mLogEnable)
+            {
+                static int frame_count =0;
+
+
+                if((++frame_count)==mLogFrameSkip)
+                    frame_count = 0;
+
+                if(frame_count==0)
+                {
+                    requestLogSample(frame_ts);
+                }
+            }
+            // <---- AEC/AGC register logging
+#endif
+            mBufMutex.unlock();
+
+            // ----> Notify the new frame
+            mNewFrameCv.notify_all();
+            if( mFrameEventFd!=-1 )
+            {
+                // The write fails only if the counter overflows, i.e. the application never reads the events
+                uint64_t evt = 1;
+                ssize_t res = write(mFrameEventFd, &evt, sizeof(evt));
+                (void)res;
+            }
+            // <---- Notify the new frame
+
+            TRACE_INSTANT("frame_published", buf.sequence);
+
+            mPublishLatency.add(getSteadyTimestamp()-dq_ts);
+
+            if( !mParams.zero_copy )
+            {
+                queueBuffer(buf.index);
+            }
+
+            // ----> Push the frame to the callbacks
+            if( mCallbackCount>0 )
+            {
+                if( mParams.zero_copy )
+                {
+                    if( cbLease.valid() )
+                    {
+                        std::shared_ptr<FrameLease> lease = std::make_shared<FrameLease>(std::move(cbLease));
+                        dispatchFrame(FramePtr(lease, &lease->frame()));
+                    }
+                }
+                else if( published )
+                {
+                    dispatchFrame(std::atomic_load(&mPublishedFrame));
+                }
+            }
+            // <---- Push the frame to the callbacks
+
+            capture_frame_count++;
+        }
+        else
+        {
+            // Give back partial frames. A failed DQBUF leaves a stale index in `buf`, that could refer to a leased buffer
+            if (ret == 0 && buf.bytesused != buf.length)
+            {
+                mBufMutex.lock();
+                mFrameStats.partial++;
+                mBufMutex.unlock();
+
+                queueBuffer(buf.index);
+            }
+            buf.bytesused = -1;
+            buf.length = 0;
+        }
+    }
+
+    mGrabRunning = false;
+}
+
+const Frame& VideoCapture::getLastFrame( uint64_t timeout_msec )
+{
+    if( mParams.zero_copy )
+    {
+        // ----> Copy the content of the last leased buffer
+        FrameLease lease = leaseLastFrame(timeout_msec);
+        if( lease.valid() && mLastFrame.data!=nullptr )
+        {
+            const Frame& frame = lease.frame();
+            mLastFrame.frame_id = frame.frame_id;
+            mLastFrame.timestamp = frame.timestamp;
+            mLastFrame.raw_timestamp = frame.raw_timestamp;
+            mLastFrame.sequence = frame.sequence;
+            memcpy(mLastFrame.data, frame.data, frame.width*frame.height*frame.channels);
+        }
+        return mLastFrame;
+        // <---- Copy the content of the last leased buffer
+    }
+
+    // Keep the frame alive until the next call
+    mLastFramePin = acquireLastFrame(timeout_msec);
+    if( !mLastFramePin )
+    {
+        return mLastFrame;
+    }
+
+    return *mLastFramePin;
+}
+
+FramePtr VideoCapture::acquireLastFrame( uint64_t timeout_msec )
+{
+    if( mParams.zero_copy )
+    {
+        // ----> The handle keeps the lease alive
+        std::shared_ptr<FrameLease> lease = std::make_shared<FrameLease>(leaseLastFrame(timeout_msec));
+        if( !lease->valid() )
+        {
+            return nullptr;
+        }
+        return FramePtr(lease, &lease->frame());
+        // <---- The handle keeps the lease alive
+    }
+
+    // ----> Wait for a new frame
+    std::unique_lock<std::mutex> lock(mBufMutex);
+    if( mNewFrameCv.wait_for(lock, std::chrono::milliseconds(timeout_msec), [this]{return mNewFrame;}) )
+    {
+        mNewFrame = false;
+    }
+    lock.unlock();
+    // <---- Wait for a new frame
+
+    FramePtr frame = std::atomic_load(&mPublishedFrame);
+    TRACE_INSTANT("frame_acquired", frame?frame->frame_id:0);
+    return frame;
+}
+
+uint64_t VideoCapture::mapTimestamp( uint64_t raw_ts )
+{
+    if( !mMonoTsSrc )
+    {
+        // ----> Unknown driver clock: difference from the first frame, received at `mStartTs`
+        if( mStartTs==0 )
+        {
+            switch( mParams.clock_domain )
+            {
+            case CLOCK_DOMAIN::MONOTONIC:
+                return getClockTimestamp(CLOCK_MONOTONIC);
+            case CLOCK_DOMAIN::BOOTTIME:
+                return getClockTimestamp(CLOCK_BOOTTIME);
+            case CLOCK_DOMAIN::WALL:
+            default:
+                return getWallTimestamp();
+            }
+        }
+
+        return mStartTs + (raw_ts - mInitTs);
+        // <---- Unknown driver clock: difference from the first frame, received at `mStartTs`
+    }
+
+    switch( mParams.clock_domain )
+    {
+    case CLOCK_DOMAIN::MONOTONIC:
+        return raw_ts;
+    case CLOCK_DOMAIN::BOOTTIME:
+    {
+        // The offset changes only when the system resumes from suspend
+        int64_t boot_offset = static_cast<int64_t>(getClockTimestamp(CLOCK_BOOTTIME)) -
+                static_cast<int64_t>(getClockTimestamp(CLOCK_MONOTONIC));
+        return raw_ts + boot_offset;
+    }
+    case CLOCK_DOMAIN::WALL:
+    default:
+        // Aligned once on the first frame: later changes of the system time do not affect the timestamps
+        return raw_ts + mWallOffset;
+    }
+}
+
+int VideoCapture::setFrameCallback( FrameCallback callback, CALLBACK_MODE mode, int worker_count, int queue_size )
+{
+    if( !callback )
+    {
+        ERROR_OUT(mParams.verbose,"Invalid frame callback");
+        return -1;
+    }
+
+    std::shared_ptr<FrameCallbackSlot> slot = std::make_shared<FrameCallbackSlot>();
+    slot->callback = callback;
+    slot->mode = mode;
+    slot->queue_size = static_cast<size_t>(std::max(1,queue_size));
+
+    if( mode==CALLBACK_MODE::WORKER_POOL )
+    {
+        for( int i=0; i<std::max(1,worker_count); i++ )
+        {
+            slot->workers.push_back(std::thread(&FrameCallbackSlot::work, slot.get()));
+        }
+    }
+
+    const std::lock_guard<std::mutex> lock(mCallbackMutex);
+    int id = mNextCallbackId++;
+    mCallbacks[id] = slot;
+    mCallbackCount = static_cast<int>(mCallbacks.size());
+
+    return id;
+}
+
+bool VideoCapture::removeFrameCallback( int id )
+{
+    std::shared_ptr<FrameCallbackSlot> slot;
+
+    {
+        // The inline callbacks are called with the lock held: no call is running after the removal
+        const std::lock_guard<std::mutex> lock(mCallbackMutex);
+        auto it = mCallbacks.find(id);
+        if( it==mCallbacks.end() )
+            return false;
+
+        slot = it->second;
+        mCallbacks.erase(it);
+        mCallbackCount = static_cast<int>(mCallbacks.size());
+    }
+
+    slot->shutdown();
+    return true;
+}
+
+void VideoCapture::removeAllFrameCallbacks()
+{
+    std::map<int,std::shared_ptr<FrameCallbackSlot>> callbacks;
+
+    mCallbackMutex.lock();
+    callbacks.swap(mCallbacks);
+    mCallbackCount = 0;
+    mCallbackMutex.unlock();
+
+    for( auto& cb : callbacks )
+    {
+        cb.second->shutdown();
+    }
+}
+
+bool VideoCapture::getCallbackStats( int id, CallbackStats& stats )
+{
+    std::shared_ptr<FrameCallbackSlot> slot;
+
+    {
+        const std::lock_guard<std::mutex> lock(mCallbackMutex);
+        auto it = mCallbacks.find(id);
+        if( it==mCallbacks.end() )
+            return false;
+        slot = it->second;
+    }
+
+    const std::lock_guard<std::mutex> lock(slot->mutex);
+    stats = slot->stats;
+    return true;
+}
+
+void VideoCapture::dispatchFrame( const FramePtr& frame )
+{
+    if( !frame )
+        return;
+
+    const std::lock_guard<std::mutex> lock(mCallbackMutex);
+    for( auto& cb : mCallbacks )
+    {
+        if( cb.second->mode==CALLBACK_MODE::INLINE )
+            cb.second->run(frame);
+        else
+            cb.second->push(frame);
+    }
+}
+
+int VideoCapture::getFreePoolFrame()
+{
+    // ----> Least recently written frames first, to keep the most recent frames available in the ring
+    int order[MAX_FRAME_POOL_SIZE+MAX_FRAME_RING_SIZE];
+    int count = static_cast<int>(mFramePool.size());
+    for( int i=0; i<count; i++ )
+    {
+        order[i] = i;
+    }
+    std::sort(order, order+count, [this](int a, int b) {
+        return mPoolVersions[a].load(std::memory_order_relaxed)<mPoolVersions[b].load(std::memory_order_relaxed);
+    });
+    // <---- Least recently written frames first, to keep the most recent frames available in the ring
+
+    // A frame referenced only by the pool is neither published nor held by the application.
+    // A subscriber can still take it from the ring, so the frame is marked as being written (odd version)
+    // before checking again that nobody holds it. The subscribers take the frame before checking its version:
+    // the two fences guarantee that at least one of the two sides detects the conflict.
+    for( int i=0; i<count; i++ )
+    {
+        int idx = order[i];
+        if( mFramePool[idx].use_count()!=1 )
+            continue;
+
+        uint64_t version = mPoolVersions[idx].load(std::memory_order_relaxed);
+        mPoolVersions[idx].store(version|1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        if( mFramePool[idx].use_count()==1 )
+            return idx;
+
+        // Taken by a subscriber in the meantime: the content is unchanged
+        mPoolVersions[idx].store(version, std::memory_order_release);
+    }
+
+    return -1;
+}
+
+FrameSubscriber VideoCapture::subscribe( SUBSCRIBER_MODE mode )
+{
+    if( mParams.zero_copy )
+    {
+        WARNING_OUT(mParams.verbose,"Frame subscribers require `VideoParams::zero_copy` to be disabled");
+        return FrameSubscriber();
+    }
+
+    return FrameSubscriber(this, mode, mRingHead.load(std::memory_order_acquire)+1);
+}
+
+FramePtr FrameSubscriber::next( uint64_t timeout_msec )
+{
+    if( !mCap )
+        return nullptr;
+
+    return mCap->readRing(*this, timeout_msec);
+}
+
+FramePtr VideoCapture::readRing( FrameSubscriber& sub, uint64_t timeout_msec )
+{
+    if( mRingSize==0 )
+        return nullptr;
+
+    // ----> Wait for a new frame
+    if( mRingHead.load(std::memory_order_acquire)<sub.mCursor )
+    {
+        std::unique_lock<std::mutex> lock(mBufMutex);
+        if( !mNewFrameCv.wait_for(lock, std::chrono::milliseconds(timeout_msec),
+                                  [this,&sub]{return mRingHead.load(std::memory_order_acquire)>=sub.mCursor;}) )
+        {
+            return nullptr;
+        }
+    }
+    // <---- Wait for a new frame
+
+    while(1)
+    {
+        uint64_t head = mRingHead.load(std::memory_order_acquire);
+        if( head<sub.mCursor )
+            return nullptr;
+
+        // ----> Select the frame to read, skipping the frames no longer in the ring
+        uint64_t target = sub.mCursor;
+        if( sub.mMode==SUBSCRIBER_MODE::LATEST_ONLY )
+            target = head;
+        else if( head-target>=mRingSize )
+            target = head-mRingSize+1;
+
+        sub.mSkipped += target-sub.mCursor;
+        sub.mCursor = target+1;
+        // <---- Select the frame to read, skipping the frames no longer in the ring
+
+        uint64_t slot = mRingSlots[target%mRingSize].load(std::memory_order_acquire);
+        if( (slot>>8)!=target )
+        {
+            // The slot has been reused by a newer frame
+            sub.mSkipped++;
+            continue;
+        }
+
+        // ----> Take the frame, then check that it has not been overwritten
+        int idx = static_cast<int>(slot&0xFF);
+        FramePtr frame = mFramePool[idx];
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        if( mPoolVersions[idx].load(std::memory_order_acquire)!=2*target )
+        {
+            sub.mSkipped++;
+            continue;
+        }
+        // <---- Take the frame, then check that it has not been overwritten
+
+        TRACE_INSTANT("frame_subscribed", target);
+        return frame;
+    }
+}
+
+FrameLease VideoCapture::leaseLastFrame( uint64_t timeout_msec )
+{
+    return leaseReadyFrame(timeout_msec, true);
+}
+
+FrameLease VideoCapture::leaseNextFrame( uint64_t timeout_msec )
+{
+    return leaseReadyFrame(timeout_msec, false);
+}
+
+FrameLease VideoCapture::leaseReadyFrame( uint64_t timeout_msec, bool newest )
+{
+    if( !mParams.zero_copy )
+    {
+        WARNING_OUT(mParams.verbose,"Frame leasing requires `VideoParams::zero_copy` to be enabled");
+        return FrameLease();
+    }
+
+    // ----> Wait for a new frame
+    std::unique_lock<std::mutex> lock(mBufMutex);
+    if( !mNewFrameCv.wait_for(lock, std::chrono::milliseconds(timeout_msec), [this]{return !mReadyBufs.empty();}) )
+    {
+        return FrameLease();
+    }
+    // <---- Wait for a new frame
+
+    int index;
+    if( newest )
+    {
+        index = mReadyBufs.back();
+        mReadyBufs.pop_back();
+
+        // Frames older than the leased one will never be leased
+        while( !mReadyBufs.empty() )
+        {
+            int old_idx = mReadyBufs.front();
+            mReadyBufs.pop_front();
+            unrefBuffer(old_idx);
+        }
+    }
+    else
+    {
+        index = mReadyBufs.front();
+        mReadyBufs.pop_front();
+    }
+
+    TRACE_INSTANT("frame_leased", mBufFrames[index].frame_id);
+
+    // The reference of the ready queue is transferred to the lease
+    return FrameLease(this, index, mBufFrames[index]);
+}
+
+bool VideoCapture::exportLastFrame( ExportedFrame& frame, uint64_t timeout_msec )
+{
+    if( !mParams.export_dmabuf )
+    {
+        WARNING_OUT(mParams.verbose,"Frame export requires `VideoParams::export_dmabuf` to be enabled");
+        return false;
+    }
+
+    FrameLease lease = leaseLastFrame(timeout_msec);
+    if( !lease.valid() )
+        return false;
+
+    const Frame& leased = lease.frame();
+    frame.dmabuf_fd = mBuffers[lease.mIndex].dmabuf_fd;
+    frame.length = mBuffers[lease.mIndex].length;
+    frame.sequence = leased.sequence;
+    frame.frame_id = leased.frame_id;
+    frame.timestamp = leased.timestamp;
+    frame.raw_timestamp = leased.raw_timestamp;
+    frame.width = leased.width;
+    frame.height = leased.height;
+    frame.channels = leased.channels;
+
+    // The lease is kept until the remote consumers release the frame
+    const std::lock_guard<std::mutex> lock(mExportMutex);
+    mExportedLeases[frame.sequence] = std::move(lease);
+
+    return true;
+}
+
+bool VideoCapture::releaseExportedFrame( uint32_t sequence )
+{
+    FrameLease lease;
+
+    {
+        const std::lock_guard<std::mutex> lock(mExportMutex);
+        std::map<uint32_t,FrameLease>::iterator it = mExportedLeases.find(sequence);
+        if( it==mExportedLeases.end() )
+            return false;
+
+        lease = std::move(it->second);
+        mExportedLeases.erase(it);
+    }
+
+    // The buffer is given back to the driver outside of `mExportMutex`
+    lease.release();
+    return true;
+}
+
+void VideoCapture::releaseAllExportedFrames()
+{
+    std::map<uint32_t,FrameLease> leases;
+
+    {
+        const std::lock_guard<std::mutex> lock(mExportMutex);
+        leases.swap(mExportedLeases);
     }
 
-    // check PID VID
-    if (pid == SL_USB_PROD_ZED_REVA && vid == SL_USB_VENDOR)
-        camera_device = SL_DEVICE::ZED;
-    else if (pid == SL_USB_PROD_ZED_M_REVA && vid == SL_USB_VENDOR)
-        camera_device = SL_DEVICE::ZED_M;
-    else if (pid == SL_USB_PROD_ZED_REVB && vid == SL_USB_VENDOR)
-        camera_device = SL_DEVICE::ZED_CBS;
-    else if (pid == SL_USB_PROD_ZED_M_REVB && vid == SL_USB_VENDOR)
-        camera_device = SL_DEVICE::ZED_M_CBS;
-    else if (pid == SL_USB_PROD_ZED_2_REVB && vid == SL_USB_VENDOR)
-        camera_device = SL_DEVICE::ZED_2;
-    else if (pid == SL_USB_PROD_ZED_2i && vid == SL_USB_VENDOR)
-        camera_device = SL_DEVICE::ZED_2i;
-
-    return camera_device;
+    // Leases are released when `leases` is destroyed
 }
 
-void VideoCapture::grabThreadFunc()
+FrameStats VideoCapture::getFrameStats()
 {
-    mNewFrame = false;
-    mStopCapture = false;
+    HistogramSnapshot latency = mPublishLatency.snapshot();
 
-    fd_set fds;
-    struct timeval tv = {0};
-
-    FD_ZERO(&fds);
+    const std::lock_guard<std::mutex> lock(mBufMutex);
+    FrameStats stats = mFrameStats;
+    stats.publish_latency_p50 = latency.percentile(50);
+    stats.publish_latency_p90 = latency.percentile(90);
+    stats.publish_latency_p99 = latency.percentile(99);
+    stats.publish_latency_max = latency.max;
+    return stats;
+}
 
-    if (mFileDesc < 0)
-        return;
+VideoStats VideoCapture::getStats()
+{
+    VideoStats stats;
 
-    FD_SET(mFileDesc, &fds);
-    tv.tv_sec = 2;
-    tv.tv_usec = 0;
-    select(mFileDesc + 1, &fds, nullptr, nullptr, &tv);
+    uint64_t interval = mFrameIntervalAvg.load(std::memory_order_relaxed);
+    stats.fps = interval?1e9/static_cast<double>(interval):0.0;
+    stats.frame_count = mReceivedFrames.load(std::memory_order_relaxed);
+    stats.frames = getFrameStats();
 
-    struct v4l2_buffer buf;
-    memset(&(buf), 0, sizeof (buf));
-    buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
-    buf.memory = V4L2_MEMORY_MMAP;
-    buf.bytesused = -1;
-    buf.length = 0;
+    stats.dqbuf_wait = mDqbufWait.snapshot();
+    stats.memcpy_time = mMemcpyTime.snapshot();
+    stats.publish_latency = mPublishLatency.snapshot();
+    stats.com_mutex_wait = mComMutexWait.snapshot();
+    stats.com_mutex_hold = mComMutexHold.snapshot();
+    stats.queue_mutex_wait = mQueueMutexWait.snapshot();
+    stats.queue_mutex_hold = mQueueMutexHold.snapshot();
 
-    uint64_t rel_ts = 0;
-    int capture_frame_count = 0;
+    stats.driver_queue_depth = mDriverBufs;
 
-    mFirstFrame=true;
+    mBufMutex.lock();
+    stats.ready_queue_depth = static_cast<int>(mReadyBufs.size());
+    mBufMutex.unlock();
 
-    while (!mStopCapture)
+    mCallbackMutex.lock();
+    for( auto& cb : mCallbacks )
     {
-        mGrabRunning=true;
-
-        mComMutex.lock();
-        int ret = ioctl(mFileDesc, VIDIOC_DQBUF, &buf);
-        mComMutex.unlock();
+        const std::lock_guard<std::mutex> lock(cb.second->mutex);
+        stats.callback_queue_depth += static_cast<int>(cb.second->queue.size());
+    }
+    mCallbackMutex.unlock();
 
-        if (buf.bytesused == buf.length && ret == 0 && buf.index < mBufCount)
-        {
-            mCurrentIndex = buf.index;
-            // get buffer timestamp in us
+    return stats;
+}
 
-            uint64_t ts_uvc = ((uint64_t) buf.timestamp.tv_sec) * (1000 * 1000) + ((uint64_t) buf.timestamp.tv_usec);
+std::string VideoCapture::getStatsText()
+{
+    VideoStats stats = getStats();
+    std::string labels = "device=\"" + mDevName + "\"";
+
+    std::ostringstream out;
+    writePrometheusValue(out, "zed_oc_video_fps", "gauge", labels, stats.fps, "Frame rate measured on the received frames");
+    writePrometheusValue(out, "zed_oc_video_frames_total", "counter", labels, stats.frame_count, "Received frames");
+    writePrometheusValue(out, "zed_oc_video_dropped_driver_total", "counter", labels, stats.frames.dropped_driver, "Frames dropped by the driver");
+    writePrometheusValue(out, "zed_oc_video_dropped_oldest_total", "counter", labels, stats.frames.dropped_oldest, "Frames discarded by the DROP_OLDEST policy");
+    writePrometheusValue(out, "zed_oc_video_dropped_newest_total", "counter", labels, stats.frames.dropped_newest, "Frames discarded by the DROP_NEWEST policy");
+    writePrometheusValue(out, "zed_oc_video_dropped_pool_total", "counter", labels, stats.frames.dropped_pool, "Frames discarded because the frame pool was full");
+    writePrometheusValue(out, "zed_oc_video_partial_total", "counter", labels, stats.frames.partial, "Incomplete frames discarded");
+    writePrometheusValue(out, "zed_oc_video_consumer_overwrite_total", "counter", labels, stats.frames.consumer_overwrite, "Frames replaced before being retrieved");
+    writePrometheusSummary(out, "zed_oc_video_dqbuf_wait_seconds", labels, stats.dqbuf_wait, 1e-9, "Time waiting for a frame to be dequeued");
+    writePrometheusSummary(out, "zed_oc_video_memcpy_seconds", labels, stats.memcpy_time, 1e-9, "Time to copy a frame in the frame pool");
+    writePrometheusSummary(out, "zed_oc_video_publish_latency_seconds", labels, stats.publish_latency, 1e-9, "Latency between the frame dequeue and its publication");
+    writePrometheusSummary(out, "zed_oc_video_com_mutex_wait_seconds", labels, stats.com_mutex_wait, 1e-9, "Time waiting for the UVC control communication mutex");
+    writePrometheusSummary(out, "zed_oc_video_com_mutex_hold_seconds", labels, stats.com_mutex_hold, 1e-9, "Time the UVC control communication mutex is held");
+    writePrometheusSummary(out, "zed_oc_video_queue_mutex_wait_seconds", labels, stats.queue_mutex_wait, 1e-9, "Time waiting for the UVC buffer queue mutex");
+    writePrometheusSummary(out, "zed_oc_video_queue_mutex_hold_seconds", labels, stats.queue_mutex_hold, 1e-9, "Time the UVC buffer queue mutex is held");
+    writePrometheusValue(out, "zed_oc_video_driver_queue_depth", "gauge", labels, stats.driver_queue_depth, "UVC buffers queued to the driver");
+    writePrometheusValue(out, "zed_oc_video_ready_queue_depth", "gauge", labels, stats.ready_queue_depth, "Dequeued UVC buffers waiting to be leased");
+    writePrometheusValue(out, "zed_oc_video_callback_queue_depth", "gauge", labels, stats.callback_queue_depth, "Frames waiting for a frame callback worker");
+
+    return out.str();
+}
 
-            if(mFirstFrame)
-            {
-                mStartTs = getWallTimestamp();
-                //std::cout << "VideoCapture: " << mStartTs << std::endl;
+void VideoCapture::startStatsDump( const std::string& path, uint32_t period_msec )
+{
+    mStatsDumper.start(path, period_msec, [this]{return getStatsText();});
+}
 
-#ifdef SENSORS_MOD_AVAILABLE
-                if(mSyncEnabled && mSensPtr)
-                {
-                    // Synchronize reference timestamp
-                    mSensPtr->setStartTimestamp(mStartTs);
-                }
-#endif
+void VideoCapture::stopStatsDump()
+{
+    mStatsDumper.stop();
+}
 
-                mFirstFrame = false;
-                mInitTs = ts_uvc;
-            }
+int VideoCapture::queueBuffer( int index )
+{
+    struct v4l2_buffer buf;
+    memset(&buf, 0, sizeof (buf));
+    buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    buf.memory = mBufMemory;
+    buf.index = index;
+    if( mBufMemory==V4L2_MEMORY_USERPTR )
+    {
+        buf.m.userptr = reinterpret_cast<unsigned long>(mBuffers[index].start);
+        buf.length = mBuffers[index].length;
+    }
 
-            rel_ts = ts_uvc - mInitTs;
-            // cvt to ns
-            rel_ts *= 1000;
+    TimedLock lock(mQueueMutex, mQueueMutexWait, mQueueMutexHold);
+    int ret = ioctl(mFileDesc, VIDIOC_QBUF, &buf);
+    if( ret==0 && (mDriverBufs++)==0 )
+    {
+        // The grabbing thread is not polling the device while no buffer is queued
+        wakeGrabThread();
+    }
+    return ret;
+}
 
-            mBufMutex.lock();
-            if (mLastFrame.data != nullptr && mWidth != 0 && mHeight != 0 && mBuffers[mCurrentIndex].start != nullptr)
-            {
-                mLastFrame.frame_id++;
-                memcpy(mLastFrame.data, (unsigned char*) mBuffers[mCurrentIndex].start, mBuffers[mCurrentIndex].length);
-                mLastFrame.timestamp = mStartTs + rel_ts;
+void VideoCapture::stopCapture()
+{
+    mStopCapture=true;
+    wakeGrabThread();
+}
 
-                //                static uint64_t last_ts=0;
-                //                std::cout << "[Video] Frame TS: " << static_cast<double>(mLastFrame.timestamp)/1e9 << " sec" << std::endl;
-                //                double dT = static_cast<double>(mLastFrame.timestamp-last_ts)/1e9;
-                //                last_ts = mLastFrame.timestamp;
-                //                std::cout << "[Video] Frame FPS: " << 1./dT << std::endl;
+void VideoCapture::wakeGrabThread()
+{
+    if( mWakeEventFd!=-1 )
+    {
+        uint64_t evt = 1;
+        ssize_t res = write(mWakeEventFd, &evt, sizeof(evt));
+        (void)res;
+    }
+}
 
-#ifdef SENSORS_MOD_AVAILABLE
-                if(mSensReadyToSync)
-                {
-                    mSensReadyToSync = false;
-                    mSensPtr->updateTimestampOffset(mLastFrame.timestamp);
-                }
-#endif
+void VideoCapture::releaseBuffer( int index )
+{
+    const std::lock_guard<std::mutex> lock(mBufMutex);
 
-#ifdef SENSOR_LOG_AVAILABLE
-                // ----> AEC/AGC register logging
-                if(mLogEnable)
-                {
-                    static int frame_count =0;
+    // The device has been closed while the buffer was leased
+    if( index<0 || index>=static_cast<int>(mBufLeases.size()) )
+        return;
 
+    unrefBuffer(index);
+}
 
-                    if((++frame_count)==mLogFrameSkip)
-                        frame_count = 0;
+void VideoCapture::unrefBuffer( int index )
+{
+    if( mBufLeases[index]>0 && --mBufLeases[index]==0 )
+    {
+        queueBuffer(index);
+    }
+}
 
-                    if(frame_count==0)
-                    {
-                        saveLogDataLeft();
-                        saveLogDataRight();
-                    }
-                }
-                // <---- AEC/AGC register logging
-#endif
+FrameLease::FrameLease( FrameLease&& other )
+{
+    *this = std::move(other);
+}
 
-                mNewFrame=true;
-            }
-            mBufMutex.unlock();
+FrameLease& FrameLease::operator=( FrameLease&& other )
+{
+    if( this!=&other )
+    {
+        release();
 
-            mComMutex.lock();
-            ioctl(mFileDesc, VIDIOC_QBUF, &buf);
-            mComMutex.unlock();
+        mCap = other.mCap;
+        mIndex = other.mIndex;
+        mFrame = other.mFrame;
 
-            capture_frame_count++;
-        }
-        else
-        {
-            if (buf.bytesused != buf.length)
-            {
-                mComMutex.lock();
-                ioctl(mFileDesc, VIDIOC_QBUF, &buf);
-                mComMutex.unlock();
-            }
-            usleep(200);
-            buf.bytesused = -1;
-            buf.length = 0;
-        }
+        other.mCap = nullptr;
+        other.mIndex = -1;
     }
 
-    mGrabRunning = false;
+    return *this;
 }
 
-const Frame& VideoCapture::getLastFrame( uint64_t timeout_msec )
+void FrameLease::release()
 {
-    // ----> Wait for a new frame
-    uint64_t time_count = timeout_msec*10;
-    while( !mNewFrame )
+    if( mCap )
     {
-        if(time_count==0)
-        {
-            return mLastFrame;
-        }
-        time_count--;
-        usleep(100);
+        mCap->releaseBuffer(mIndex);
+
+        mCap = nullptr;
+        mIndex = -1;
+        mFrame = Frame();
     }
-    // <---- Wait for a new frame
+}
 
-    // Get the frame mutex
-    const std::lock_guard<std::mutex> lock(mBufMutex);
-    mNewFrame = false;
-    return mLastFrame;
+int VideoCapture::ll_xuQuery(struct uvc_xu_control_query& query)
+{
+    if( mXuTransport )
+        return mXuTransport(query);
+
+    return (ioctl(mFileDesc, UVCIOC_CTRL_QUERY, &query)==0)?0:errno;
+}
+
+void VideoCapture::setXuTransport( XuTransport transport )
+{
+    const std::lock_guard<std::mutex> lock(mComMutex);
+
+    mXuTransport = transport;
+
+    // The new transport can have a different control length and completion time
+    mXuLen = 0;
+    mXuPoll.reset();
+    mXuSafePoll.reset();
 }
 
 int VideoCapture::ll_VendorControl(uint8_t *buf, int len, int readMode, bool safe, bool force)
@@ -913,31 +2358,38 @@ int VideoCapture::ll_VendorControl(uint8_t *buf, int len, int readMode, bool saf
     if (len > 384)
         return -2;
 
-    if (!force && !mInitialized)
+    if (!force && !mInitialized && !mXuTransport)
         return -3;
 
-    unsigned char tmp[2] = {0};
-    struct uvc_xu_control_query xu_query_info;
-    xu_query_info.unit = cbs_xu_unit_id;
-    xu_query_info.selector = cbs_xu_control_selector;
-    xu_query_info.query = UVC_GET_LEN;
-    xu_query_info.size = 2;
-    xu_query_info.data = tmp;
+    TRACE_SCOPE("xu_command", buf[0]);
+    TimedLock lock(mComMutex, mComMutexWait, mComMutexHold);
 
-    const std::lock_guard<std::mutex> lock(mComMutex);
+    // ----> Control length, queried only once for each opened device
+    if( mXuLen==0 )
+    {
+        unsigned char tmp[2] = {0};
+        struct uvc_xu_control_query xu_query_info;
+        xu_query_info.unit = cbs_xu_unit_id;
+        xu_query_info.selector = cbs_xu_control_selector;
+        xu_query_info.query = UVC_GET_LEN;
+        xu_query_info.size = 2;
+        xu_query_info.data = tmp;
 
-    int io_err = ioctl(mFileDesc, UVCIOC_CTRL_QUERY, &xu_query_info);
+        int io_err = ll_xuQuery(xu_query_info);
 
-    //std::cerr << "[ll_VendorControl] '" << mDevName << "' [" << mDevId << "] - mFileDesc: " << mFileDesc << std::endl;
+        //std::cerr << "[ll_VendorControl] '" << mDevName << "' [" << mDevId << "] - mFileDesc: " << mFileDesc << std::endl;
 
-    if (io_err != 0)
-    {
-        return -4;
-    }
-    else
-    {
-        len = (xu_query_info.data[1] << 8) + xu_query_info.data[0];
+        if (io_err != 0)
+        {
+            return -4;
+        }
+
+        mXuLen = (xu_query_info.data[1] << 8) + xu_query_info.data[0];
     }
+    len = mXuLen;
+    // <---- Control length, queried only once for each opened device
+
+    XuPoller& poller = safe?mXuSafePoll:mXuPoll;
 
     //len should be now 384 for USB3 and 64 for USB2
     // we use the UVC_SET_CUR to write the cmd
@@ -948,11 +2400,13 @@ int VideoCapture::ll_VendorControl(uint8_t *buf, int len, int readMode, bool saf
     xu_query_send.size = static_cast<__u16> (len); //64 for USB2
     xu_query_send.data = buf;
 
-    io_err = ioctl(mFileDesc, UVCIOC_CTRL_QUERY, &xu_query_send);
-    if (io_err != 0)
+    // The camera stalls the request if it is still executing the previous command.
+    // A timed out request is not sent again: the camera may have received it
+    int res = poller.run([&]{
+        return ll_xuQuery(xu_query_send);
+    }, false);
+    if (res != 0)
     {
-        int res = errno;
-
         const char *err=nullptr;
         switch (res) {
         case ENOENT:
@@ -986,12 +2440,6 @@ int VideoCapture::ll_VendorControl(uint8_t *buf, int len, int readMode, bool saf
         return -1;
     }
 
-#if 1
-    if (!safe)
-        usleep(300);
-    else
-        usleep(2000);
-
     if (readMode == READ_MODE) {
 
         struct uvc_xu_control_query xu_query;
@@ -1001,10 +2449,11 @@ int VideoCapture::ll_VendorControl(uint8_t *buf, int len, int readMode, bool saf
                 xu_query.size = static_cast<__u16> (len),
                 xu_query.data = buf;
 
-        io_err = ioctl(mFileDesc, UVCIOC_CTRL_QUERY, &xu_query);
-        if (io_err != 0) {
-            int res = errno;
-
+        // Wait for the typical completion time, then poll until the camera answers
+        res = poller.run([&]{
+            return ll_xuQuery(xu_query);
+        });
+        if (res != 0) {
             const char *err;
             switch (res) {
             case ENOENT: err = "Extension unit or control not found";
@@ -1036,12 +2485,11 @@ int VideoCapture::ll_VendorControl(uint8_t *buf, int len, int readMode, bool saf
     }
     else
     {
+        // Give the camera the time to complete before the next command
+        usleep(poller.currentWait());
+
         return 0;
     }
-
-#endif
-
-
 }
 
 /**
@@ -1107,146 +2555,219 @@ int VideoCapture::ll_set_gpio_direction(int gpio_number, int direction)
     return hr;
 }
 
-int VideoCapture::ll_read_system_register(uint64_t address, uint8_t *value)
+int VideoCapture::ll_burstPayloadSize()
 {
-    unsigned char xu_buf[384];
-    memset(xu_buf, 0, 384);
+    // Before the first command the control length is unknown: use the USB2 length
+    int xu_len = mXuLen;
+    if( xu_len==0 )
+        xu_len = 64;
+
+    return xu_len - XU_BURST_READ_OFFSET;
+}
+
+int VideoCapture::ll_read_system_registers(uint64_t address, uint8_t *values, int count)
+{
+    int chunk = ll_burstPayloadSize();
+    int hr = 0;
+
+    while( count>0 )
+    {
+        int n = std::min(count, chunk);
+
+        unsigned char xu_buf[384];
+        memset(xu_buf, 0, 384);
+
+        //Set xubuf
+        xu_buf[0] = XU_TASK_GET;
+        xu_buf[1] = 0xA2;
+        xu_buf[2] = 0;
+        xu_buf[3] = 0x04; //Address width in bytes
+        xu_buf[4] = 0x01; //data width in bytes
+
+        xu_buf[5] = ((address) >> 24) & 0xff;
+        xu_buf[6] = ((address) >> 16) & 0xff;
+        xu_buf[7] = ((address) >> 8) & 0xff;
+        xu_buf[8] = (address) & 0xff;
+        xu_buf[9] = (n >> 8) & 0xff;    // Number of registers
+        xu_buf[10] = (n >> 0) & 0xff;
+        xu_buf[11] = (n >> 8) & 0xff;   // Data length in bytes
+        xu_buf[12] = (n >> 0) & 0xff;
+
+        int res = ll_VendorControl(xu_buf, 384, READ_MODE);
+        memcpy(values, &xu_buf[XU_BURST_READ_OFFSET], n);
+        if( res!=0 )
+            hr = res;
+
+        address += n;
+        values += n;
+        count -= n;
+    }
 
-    //Set xubuf
-    xu_buf[0] = XU_TASK_GET;
-    xu_buf[1] = 0xA2;
-    xu_buf[2] = 0;
-    xu_buf[3] = 0x04; //Address width in bytes
-    xu_buf[4] = 0x01; //data width in bytes
-
-    xu_buf[5] = ((address) >> 24) & 0xff;
-    xu_buf[6] = ((address) >> 16) & 0xff;
-    xu_buf[7] = ((address) >> 8) & 0xff;
-    xu_buf[8] = (address) & 0xff;
-    xu_buf[9] = 0x00;
-    xu_buf[10] = 0x01;
-    xu_buf[11] = 0x00;
-    xu_buf[12] = 0x01;
-
-    int hr = ll_VendorControl(xu_buf, 384, READ_MODE);
-    *value = xu_buf[17];
     return hr;
 }
 
-int VideoCapture::ll_write_system_register(uint64_t address, uint8_t value)
+int VideoCapture::ll_write_system_registers(uint64_t address, const uint8_t *values, int count)
 {
-    unsigned char xu_buf[384];
-    memset(xu_buf, 0, 384);
+    int chunk = ll_burstPayloadSize();
+    int hr = 0;
+
+    while( count>0 )
+    {
+        int n = std::min(count, chunk);
+
+        unsigned char xu_buf[384];
+        memset(xu_buf, 0, 384);
+
+        //Set xubuf
+        xu_buf[0] = XU_TASK_SET;
+        xu_buf[1] = 0xA2;
+        xu_buf[2] = 0;
+        xu_buf[3] = 0x04; //Address width in bytes
+        xu_buf[4] = 0x01; //data width in bytes
+
+        xu_buf[5] = ((address) >> 24) & 0xff;
+        xu_buf[6] = ((address) >> 16) & 0xff;
+        xu_buf[7] = ((address) >> 8) & 0xff;
+        xu_buf[8] = (address) & 0xff;
+        xu_buf[9] = (n >> 8) & 0xff;    // Number of registers
+        xu_buf[10] = (n >> 0) & 0xff;
+        xu_buf[11] = (n >> 8) & 0xff;   // Data length in bytes
+        xu_buf[12] = (n >> 0) & 0xff;
+        memcpy(&xu_buf[XU_BURST_WRITE_OFFSET], values, n);
+
+        int res = ll_VendorControl(xu_buf, 384, 0);
+        if( res!=0 )
+            hr = res;
+
+        address += n;
+        values += n;
+        count -= n;
+    }
 
-    //Set xubuf
-    xu_buf[0] = XU_TASK_SET;
-    xu_buf[1] = 0xA2;
-    xu_buf[2] = 0;
-    xu_buf[3] = 0x04; //Address width in bytes
-    xu_buf[4] = 0x01; //data width in bytes
-
-    xu_buf[5] = ((address) >> 24) & 0xff;
-    xu_buf[6] = ((address) >> 16) & 0xff;
-    xu_buf[7] = ((address) >> 8) & 0xff;
-    xu_buf[8] = (address) & 0xff;
-    xu_buf[9] = 0x00;
-    xu_buf[10] = 0x01;
-    xu_buf[11] = 0x00;
-    xu_buf[12] = 0x01;
-    xu_buf[16] = value;
-
-    int hr = ll_VendorControl(xu_buf, 384, 0);
     return hr;
 }
 
+int VideoCapture::ll_read_system_register(uint64_t address, uint8_t *value)
+{
+    return ll_read_system_registers(address, value, 1);
+}
+
+int VideoCapture::ll_write_system_register(uint64_t address, uint8_t value)
+{
+    return ll_write_system_registers(address, &value, 1);
+}
+
 #define ASIC_INT_NULL_I2C    0xa3
 #define ASIC_INT_I2C         0xa5
 
-int VideoCapture::ll_read_sensor_register(int side, int sscb_id, uint64_t address, uint8_t* value)
+int VideoCapture::ll_read_sensor_registers(int side, int sscb_id, uint64_t address, uint8_t *values, int count)
 {
-    unsigned char xu_buf[384];
-    memset(xu_buf, 0, 384);
+    int chunk = ll_burstPayloadSize();
+    int hr = 0;
+
+    while( count>0 )
+    {
+        int n = std::min(count, chunk);
 
+        unsigned char xu_buf[384];
+        memset(xu_buf, 0, 384);
 
-    //Set xubuf
-    xu_buf[0] = XU_TASK_GET;
-    if (side == 0)
-        xu_buf[1] = ASIC_INT_NULL_I2C;
-    else
-        xu_buf[1] = ASIC_INT_I2C;
-    xu_buf[2] = 0x6c;
-    xu_buf[3] = sscb_id + 1; //Address width in bytes
-    xu_buf[4] = 0x01; //data width in bytes
+        //Set xubuf
+        xu_buf[0] = XU_TASK_GET;
+        if (side == 0)
+            xu_buf[1] = ASIC_INT_NULL_I2C;
+        else
+            xu_buf[1] = ASIC_INT_I2C;
+        xu_buf[2] = 0x6c;
+        xu_buf[3] = sscb_id + 1; //Address width in bytes
+        xu_buf[4] = 0x01; //data width in bytes
+
+        xu_buf[5] = ((address) >> 24) & 0xff;
+        xu_buf[6] = ((address) >> 16) & 0xff;
+        xu_buf[7] = ((address) >> 8) & 0xff;
+        xu_buf[8] = (address) & 0xff;
+
+        xu_buf[9] = (n >> 8) & 0xff;    // Number of registers
+        xu_buf[10] = (n >> 0) & 0xff;
+        xu_buf[11] = (n >> 8) & 0xff;   // Data length in bytes
+        xu_buf[12] = (n >> 0) & 0xff;
+
+        //set page addr
+        xu_buf[9] = xu_buf[9] & 0x0f;
+        xu_buf[9] = xu_buf[9] | 0x10;
+        xu_buf[9] = xu_buf[9] | 0x80;
+
+        int res = ll_VendorControl(xu_buf, 384, READ_MODE);
+        memcpy(values, &xu_buf[XU_BURST_READ_OFFSET], n);
+        if( res!=0 )
+            hr = res;
+
+        address += n;
+        values += n;
+        count -= n;
+    }
 
-    xu_buf[5] = ((address) >> 24) & 0xff;
-    xu_buf[6] = ((address) >> 16) & 0xff;
-    xu_buf[7] = ((address) >> 8) & 0xff;
-    xu_buf[8] = (address) & 0xff;
+    return hr;
+}
 
-    xu_buf[9] = 0x00;
-    xu_buf[10] = 0x01;
-    xu_buf[11] = 0x00;
-    xu_buf[12] = 0x01;
+int VideoCapture::ll_write_sensor_registers(int side, int sscb_id, uint64_t address, const uint8_t *values, int count)
+{
+    int chunk = ll_burstPayloadSize();
+    int hr = 0;
 
-    int limit = 1;
+    while( count>0 )
+    {
+        int n = std::min(count, chunk);
 
-    xu_buf[9] = (limit >> 8) & 0xff;
-    xu_buf[10] = (limit >> 0) & 0xff;
+        unsigned char xu_buf[384];
+        memset(xu_buf, 0, 384);
 
-    //set page addr
-    xu_buf[9] = xu_buf[9] & 0x0f;
-    xu_buf[9] = xu_buf[9] | 0x10;
-    xu_buf[9] = xu_buf[9] | 0x80;
+        //Set xubuf
+        xu_buf[0] = XU_TASK_SET;
+        if (side == 0)
+            xu_buf[1] = ASIC_INT_NULL_I2C;
+        else
+            xu_buf[1] = ASIC_INT_I2C;
+        xu_buf[2] = 0x6c;
+        xu_buf[3] = sscb_id + 1; //Address width in bytes
+        xu_buf[4] = 0x01; //data width in bytes
+
+        xu_buf[5] = ((address) >> 24) & 0xff;
+        xu_buf[6] = ((address) >> 16) & 0xff;
+        xu_buf[7] = ((address) >> 8) & 0xff;
+        xu_buf[8] = (address) & 0xff;
+
+        xu_buf[9] = (n >> 8) & 0xff;    // Number of registers
+        xu_buf[10] = (n >> 0) & 0xff;
+        xu_buf[11] = (n >> 8) & 0xff;   // Data length in bytes
+        xu_buf[12] = (n >> 0) & 0xff;
+
+        //set page addr
+        xu_buf[9] = xu_buf[9] & 0x0f;
+        xu_buf[9] = xu_buf[9] | 0x10;
+        xu_buf[9] = xu_buf[9] | 0x80;
+        memcpy(&xu_buf[XU_BURST_WRITE_OFFSET], values, n);
+
+        int res = ll_VendorControl(xu_buf, 384, 0);
+        if( res!=0 )
+            hr = res;
+
+        address += n;
+        values += n;
+        count -= n;
+    }
 
-    int hr = ll_VendorControl(xu_buf, 384, READ_MODE);
-    *value = xu_buf[17];
     return hr;
 }
 
-int VideoCapture::ll_write_sensor_register(int side, int sscb_id, uint64_t address, uint8_t value)
+int VideoCapture::ll_read_sensor_register(int side, int sscb_id, uint64_t address, uint8_t* value)
 {
+    return ll_read_sensor_registers(side, sscb_id, address, value, 1);
+}
 
-    unsigned char xu_buf[384];
-    memset(xu_buf, 0, 384);
-
-    //Set xubuf
-    xu_buf[0] = XU_TASK_SET;
-    if (side == 0)
-        xu_buf[1] = ASIC_INT_NULL_I2C;
-    else
-        xu_buf[1] = ASIC_INT_I2C;
-    xu_buf[2] = 0x6c;
-    xu_buf[3] = sscb_id + 1; //Address width in bytes
-    xu_buf[4] = 0x01; //data width in bytes
-
-    xu_buf[5] = ((address) >> 24) & 0xff;
-    xu_buf[6] = ((address) >> 16) & 0xff;
-    xu_buf[7] = ((address) >> 8) & 0xff;
-    xu_buf[8] = (address) & 0xff;
-    xu_buf[9] = 0x00;
-    xu_buf[10] = 0x01;
-    xu_buf[11] = 0x00;
-    xu_buf[12] = 0x01;
-    xu_buf[16] = value;
-
-
-    xu_buf[9] = 0x00;
-    xu_buf[10] = 0x01;
-    xu_buf[11] = 0x00;
-    xu_buf[12] = 0x01;
-
-    int limit = 1;
-    xu_buf[9] = (limit >> 8) & 0xff;
-    xu_buf[10] = (limit >> 0) & 0xff;
-
-    //set page addr
-    xu_buf[9] = xu_buf[9] & 0x0f;
-    xu_buf[9] = xu_buf[9] | 0x10;
-    xu_buf[9] = xu_buf[9] | 0x80;
-    memcpy(&xu_buf[16], &value, sizeof (uint8_t));
-    int hr = ll_VendorControl(xu_buf, 384, 0);
-
-    return hr;
+int VideoCapture::ll_write_sensor_register(int side, int sscb_id, uint64_t address, uint8_t value)
+{
+    return ll_write_sensor_registers(side, sscb_id, address, &value, 1);
 }
 
 int VideoCapture::ll_SPI_FlashProgramRead(uint8_t *pBuf, int Adr, int len, bool force) {
@@ -1327,56 +2848,40 @@ int VideoCapture::ll_isp_is_aecagc(int side) {
 }
 
 int VideoCapture::ll_isp_get_gain(uint8_t *val, uint8_t sensorID) {
-    int hr = 0;
-    uint8_t buffL, buffM, buffH;
+    // H, M, L registers are contiguous
+    uint8_t buff[3] = {0};
+    int hr = ll_read_sensor_registers(sensorID, 1, ADDR_GAIN_H, buff, 3);
 
-    hr += ll_read_sensor_register(sensorID, 1, ADDR_GAIN_H, &buffH);
-    hr += ll_read_sensor_register(sensorID, 1, ADDR_GAIN_M, &buffM);
-    hr += ll_read_sensor_register(sensorID, 1, ADDR_GAIN_L, &buffL);
-
-    *val = buffL;
-    *(val + 1) = buffM;
-    *(val + 2) = buffH;
+    *val = buff[2];
+    *(val + 1) = buff[1];
+    *(val + 2) = buff[0];
 
     return hr;
 }
 
 int VideoCapture::ll_isp_set_gain(unsigned char ucGainH, unsigned char ucGainM, unsigned char ucGainL, int sensorID)
 {
-    int hr = 0;
-    hr += ll_write_sensor_register(sensorID, 1, ADDR_GAIN_H, ucGainH);
-    hr += ll_write_sensor_register(sensorID, 1, ADDR_GAIN_M, ucGainM);
-    hr += ll_write_sensor_register(sensorID, 1, ADDR_GAIN_L, ucGainL);
-    return hr;
+    const uint8_t buff[3] = {ucGainH, ucGainM, ucGainL};
+    return ll_write_sensor_registers(sensorID, 1, ADDR_GAIN_H, buff, 3);
 }
 
 int VideoCapture::ll_isp_get_exposure(unsigned char *val, unsigned char sensorID)
 {
-    int hr = 0;
-    uint8_t buffL = 0;
-    uint8_t buffM = 0;
-    uint8_t buffH = 0;
+    // H, M, L registers are contiguous
+    uint8_t buff[3] = {0};
+    int hr = ll_read_sensor_registers(sensorID, 1, ADDR_EXP_H, buff, 3);
 
-    hr += ll_read_sensor_register(sensorID, 1, ADDR_EXP_H, (uint8_t*) & buffH);
-    usleep(10);
-    hr += ll_read_sensor_register(sensorID, 1, ADDR_EXP_M, (uint8_t*) & buffM);
-    usleep(10);
-    hr += ll_read_sensor_register(sensorID, 1, ADDR_EXP_L, (uint8_t*) & buffL);
-
-    *val = buffL;
-    *(val + 1) = buffM;
-    *(val + 2) = buffH;
+    *val = buff[2];
+    *(val + 1) = buff[1];
+    *(val + 2) = buff[0];
 
     return hr;
 }
 
 int VideoCapture::ll_isp_set_exposure(unsigned char ucExpH, unsigned char ucExpM, unsigned char ucExpL, int sensorID)
 {
-    int hr = 0;
-    hr += ll_write_sensor_register(sensorID, 1, ADDR_EXP_H, ucExpH);
-    hr += ll_write_sensor_register(sensorID, 1, ADDR_EXP_M, ucExpM);
-    hr += ll_write_sensor_register(sensorID, 1, ADDR_EXP_L, ucExpL);
-    return hr;
+    const uint8_t buff[3] = {ucExpH, ucExpM, ucExpL};
+    return ll_write_sensor_registers(sensorID, 1, ADDR_EXP_H, buff, 3);
 }
 
 void VideoCapture::ll_activate_sync()
@@ -1452,84 +2957,233 @@ int VideoCapture::toggleLED(bool* value)
 int VideoCapture::getCameraControlSettings(int ctrl_id)
 {
     struct v4l2_control control_s;
-    struct v4l2_queryctrl queryctrl;
-    memset(&queryctrl, 0, sizeof (queryctrl));
     memset(&control_s, 0, sizeof (control_s));
     int res = -1;
 
-    // save_controls(fd);
+    const std::lock_guard<std::mutex> lock(mControlsMutex);
+
+    ControlShadow& ctrl = findCameraControl(ctrl_id);
+    if (!ctrl.available)
+        return res;
+
+    // ----> Served from the shadow state unless the camera can change the value
+    if (ctrl.valid && !isControlVolatile(ctrl_id))
+        return ctrl.value;
+    // <---- Served from the shadow state unless the camera can change the value
+
+    control_s.id = ctrl_id;
+    if (ioctl(mFileDesc, VIDIOC_G_CTRL, &control_s) == 0) {
+        res = (int) control_s.value;
+        ctrl.value = res;
+        ctrl.valid = true;
+    }
+
+    return res;
+}
+
+void VideoCapture::loadCameraControls()
+{
+    static const int ctrl_ids[] = {
+        LINUX_CTRL_BRIGHTNESS, LINUX_CTRL_CONTRAST, LINUX_CTRL_HUE, LINUX_CTRL_SATURATION, LINUX_CTRL_GAIN,
+        LINUX_CTRL_AWB, LINUX_CTRL_AWB_AUTO, LINUX_CTRL_SHARPNESS, LINUX_CTRL_GAMMA
+    };
+
+    const std::lock_guard<std::mutex> lock(mControlsMutex);
+    mControls.clear();
+
+    for( int ctrl_id : ctrl_ids )
+        queryCameraControl(ctrl_id, mControls[ctrl_id]);
+}
+
+void VideoCapture::queryCameraControl(int ctrl_id, ControlShadow& ctrl)
+{
+    struct v4l2_queryctrl queryctrl;
+    memset(&queryctrl, 0, sizeof (queryctrl));
     queryctrl.id = ctrl_id;
 
-    if (0 != ioctl(mFileDesc, VIDIOC_QUERYCTRL, &queryctrl))
-        return res;
+    ctrl = ControlShadow();
+
+    if (0 == ioctl(mFileDesc, VIDIOC_QUERYCTRL, &queryctrl)) {
+        ctrl.available = true;
+        ctrl.min = queryctrl.minimum;
+        ctrl.max = queryctrl.maximum;
+        ctrl.def = queryctrl.default_value;
+        ctrl.volatile_val = (queryctrl.flags & V4L2_CTRL_FLAG_VOLATILE)!=0;
+
+        if (ctrl_id == LINUX_CTRL_GAMMA) {
+            ctrl.min = DEFAULT_MIN_GAMMA;
+            ctrl.max = DEFAULT_MAX_GAMMA;
+        }
+
+        struct v4l2_control control_s;
+        memset(&control_s, 0, sizeof (control_s));
+        control_s.id = ctrl_id;
+        if (ioctl(mFileDesc, VIDIOC_G_CTRL, &control_s) == 0) {
+            ctrl.value = control_s.value;
+            ctrl.valid = true;
+        }
+    } else {
+        ctrl.min = 0; // queryctrl.minimum;
+        ctrl.max = 6500; // queryctrl.maximum;
+    }
+}
+
+ControlShadow& VideoCapture::findCameraControl(int ctrl_id)
+{
+    std::map<int,ControlShadow>::iterator it = mControls.find(ctrl_id);
+    if( it!=mControls.end() )
+        return it->second;
+
+    // Not recorded when the camera was opened: query the range now
+    ControlShadow& ctrl = mControls[ctrl_id];
+    queryCameraControl(ctrl_id, ctrl);
+    return ctrl;
+}
+
+bool VideoCapture::isControlVolatile(int ctrl_id)
+{
+    std::map<int,ControlShadow>::iterator it = mControls.find(ctrl_id);
+    if( it!=mControls.end() && it->second.volatile_val )
+        return true;
 
-    control_s.id = ctrl_id;
-    if (ioctl(mFileDesc, VIDIOC_G_CTRL, &control_s) == 0)
-        res = (int) control_s.value;
+    // The white balance is changed by the camera while the automatic white balance is active
+    if( ctrl_id==LINUX_CTRL_AWB )
+    {
+        std::map<int,ControlShadow>::iterator awb_auto = mControls.find(LINUX_CTRL_AWB_AUTO);
+        return awb_auto==mControls.end() || !awb_auto->second.valid || awb_auto->second.value!=0;
+    }
 
-    return res;
+    return false;
 }
 
-void VideoCapture::setCameraControlSettings(int ctrl_id, int ctrl_val) {
+bool VideoCapture::setCameraControlSettings(int ctrl_id, int ctrl_val) {
     struct v4l2_control control_s;
-    struct v4l2_queryctrl queryctrl;
-    memset(&queryctrl, 0, sizeof (queryctrl));
     memset(&control_s, 0, sizeof (control_s));
-    int min, max/*, step, val_def*/;
-
-    // save_controls(fd);
-    queryctrl.id = ctrl_id;
 
     //std::cerr << "[setCameraControlSettings] '" << mDevName << "' [" << mDevId << "] - mFileDesc: " << mFileDesc << std::endl;
 
-    int res = ioctl(mFileDesc, VIDIOC_QUERYCTRL, &queryctrl);
-    if (0 == res) {
-        min = queryctrl.minimum;
-        max = queryctrl.maximum;
-        //step = queryctrl.step;
-        //val_def = queryctrl.default_value;
+    const std::lock_guard<std::mutex> lock(mControlsMutex);
 
-        if (ctrl_id == LINUX_CTRL_GAMMA) {
-            min = DEFAULT_MIN_GAMMA;
-            max = DEFAULT_MAX_GAMMA;
-        }
-
-    } else {
-        min = 0; // queryctrl.minimum;
-        max = 6500; // queryctrl.maximum;
-        //step = queryctrl.step;
-        //val_def = queryctrl.default_value;
-    }
+    // The range is read once when the camera is opened
+    ControlShadow& ctrl = findCameraControl(ctrl_id);
 
-    if ((ctrl_val >= min) && (ctrl_val <= max)) {
+    if ((ctrl_val >= ctrl.min) && (ctrl_val <= ctrl.max)) {
         control_s.id = ctrl_id;
         control_s.value = ctrl_val;
 
+        if (ioctl(mFileDesc, VIDIOC_S_CTRL, &control_s) == 0) {
+            ctrl.value = ctrl_val;
+            ctrl.valid = true;
 
-        if (ioctl(mFileDesc, VIDIOC_S_CTRL, &control_s) == 0)
-            return;
-    } else
-        return;
+            // The white balance set by the automatic mode is not known
+            if (ctrl_id == LINUX_CTRL_AWB_AUTO)
+                findCameraControl(LINUX_CTRL_AWB).valid = false;
+            return true;
+        }
+
+        // Unknown state: read it again at the next request
+        ctrl.valid = false;
+    }
+
+    return false;
 }
 
 void VideoCapture::resetCameraControlSettings(int ctrl_id) {
 
     struct v4l2_control control_s;
-    struct v4l2_queryctrl queryctrl;
-    memset(&queryctrl, 0, sizeof (queryctrl));
     memset(&control_s, 0, sizeof (control_s));
-    int val_def;
-    // save_controls(fd);
-    queryctrl.id = ctrl_id;
-    ioctl(mFileDesc, VIDIOC_QUERYCTRL, &queryctrl);
-    val_def = queryctrl.default_value;
+
+    const std::lock_guard<std::mutex> lock(mControlsMutex);
+
+    std::map<int,ControlShadow>::iterator it = mControls.find(ctrl_id);
+    int val_def = (it!=mControls.end())?it->second.def:0;
 
     control_s.id = ctrl_id;
     control_s.value = val_def;
-    ioctl(mFileDesc, VIDIOC_S_CTRL, &control_s);
+    bool ok = (ioctl(mFileDesc, VIDIOC_S_CTRL, &control_s) == 0);
+    if (it!=mControls.end()) {
+        it->second.value = val_def;
+        it->second.valid = ok;
+    }
+    if (ctrl_id == LINUX_CTRL_AWB_AUTO)
+        findCameraControl(LINUX_CTRL_AWB).valid = false;
     return;
 }
 
+bool VideoCapture::setCameraControlsBatch(const std::vector<std::pair<int,int>>& ctrls)
+{
+    bool ok = true;
+
+    const std::lock_guard<std::mutex> lock(mControlsMutex);
+
+    // ----> Controls that differ from the shadow state
+    std::vector<struct v4l2_ext_control> changed;
+    for( const std::pair<int,int>& ctrl : ctrls )
+    {
+        ControlShadow& shadow = findCameraControl(ctrl.first);
+        if( !shadow.available || ctrl.second<shadow.min || ctrl.second>shadow.max )
+        {
+            ok = false;
+            continue;
+        }
+
+        if( shadow.valid && !isControlVolatile(ctrl.first) && shadow.value==ctrl.second )
+            continue;
+
+        struct v4l2_ext_control ext_ctrl;
+        memset(&ext_ctrl, 0, sizeof (ext_ctrl));
+        ext_ctrl.id = ctrl.first;
+        ext_ctrl.value = ctrl.second;
+        changed.push_back(ext_ctrl);
+    }
+    // <---- Controls that differ from the shadow state
+
+    if( changed.empty() )
+        return ok;
+
+    struct v4l2_ext_controls ext_ctrls;
+    memset(&ext_ctrls, 0, sizeof (ext_ctrls));
+    ext_ctrls.ctrl_class = V4L2_CTRL_CLASS_USER;
+    ext_ctrls.count = changed.size();
+    ext_ctrls.controls = changed.data();
+
+    if( ioctl(mFileDesc, VIDIOC_S_EXT_CTRLS, &ext_ctrls)==0 )
+    {
+        for( const struct v4l2_ext_control& ext_ctrl : changed )
+        {
+            ControlShadow& shadow = findCameraControl(ext_ctrl.id);
+            shadow.value = ext_ctrl.value;
+            shadow.valid = true;
+        }
+    }
+    else
+    {
+        // The request is rejected as a whole by the driver: write the controls one by one
+        for( const struct v4l2_ext_control& ext_ctrl : changed )
+        {
+            struct v4l2_control control_s;
+            memset(&control_s, 0, sizeof (control_s));
+            control_s.id = ext_ctrl.id;
+            control_s.value = ext_ctrl.value;
+
+            bool res = (ioctl(mFileDesc, VIDIOC_S_CTRL, &control_s) == 0);
+            ControlShadow& shadow = findCameraControl(ext_ctrl.id);
+            shadow.value = ext_ctrl.value;
+            shadow.valid = res;
+            ok = ok && res;
+        }
+    }
+
+    // The white balance set by the automatic mode is not known
+    for( const struct v4l2_ext_control& ext_ctrl : changed )
+    {
+        if( ext_ctrl.id==LINUX_CTRL_AWB_AUTO )
+            findCameraControl(LINUX_CTRL_AWB).valid = false;
+    }
+
+    return ok;
+}
+
 int VideoCapture::setGammaPreset(int side, int value)
 {
     if (!mInitialized)
@@ -1540,6 +3194,11 @@ int VideoCapture::setGammaPreset(int side, int value)
     if(value > DEFAULT_MAX_GAMMA)
         value = DEFAULT_MAX_GAMMA;
 
+    // Unknown until the preset is verified
+    mControlsMutex.lock();
+    mXuShadow.gamma_preset[side?1:0] = -1;
+    mControlsMutex.unlock();
+
     uint64_t ulAddr = 0x80181500;
 
     if (side == 1)
@@ -1547,15 +3206,11 @@ int VideoCapture::setGammaPreset(int side, int value)
 
     int hr = 0;
 
-    for (int i = 0; i < 15; i++) {
-        hr += ll_write_system_register(ulAddr, PRESET_GAMMA[value-1][i]);
-        usleep(10);
-        uint8_t valRead = 0x0;
-        hr += ll_read_system_register(ulAddr, &valRead);
-        if (valRead != PRESET_GAMMA[value-1][i]) {
-            return -3;
-        }
-        ulAddr++;
+    hr += ll_write_system_registers(ulAddr, PRESET_GAMMA[value-1], 15);
+    uint8_t valsRead[15] = {0};
+    hr += ll_read_system_registers(ulAddr, valsRead, 15);
+    if (memcmp(valsRead, PRESET_GAMMA[value-1], 15) != 0) {
+        return -3;
     }
 
     ulAddr = 0x80181510;
@@ -1563,12 +3218,16 @@ int VideoCapture::setGammaPreset(int side, int value)
     if (side == 1)
         ulAddr = 0x80181D10;
     hr += ll_write_system_register(ulAddr, 0x01);
-    usleep(10);
     uint8_t valRead = 0x0;
     hr += ll_read_system_register(ulAddr, &valRead);
     if (valRead != 0x01)
         return -2;
 
+    if (hr == 0) {
+        const std::lock_guard<std::mutex> lock(mControlsMutex);
+        mXuShadow.gamma_preset[side?1:0] = value;
+    }
+
     return hr;
 }
 
@@ -1653,12 +3312,17 @@ int VideoCapture::getWhiteBalance()
 }
 
 void VideoCapture::setWhiteBalance(int wb)
+{
+    writeWhiteBalance(wb);
+}
+
+bool VideoCapture::writeWhiteBalance(int wb)
 {
     // Disable auto white balance if active
-    if (getAutoWhiteBalance() != 0)
-        setAutoWhiteBalance(false);
+    if (getAutoWhiteBalance() != 0 && !setCameraControlSettings(LINUX_CTRL_AWB_AUTO, 0))
+        return false;
 
-    setCameraControlSettings(LINUX_CTRL_AWB, wb);
+    return setCameraControlSettings(LINUX_CTRL_AWB, wb);
 }
 
 bool VideoCapture::getAutoWhiteBalance()
@@ -1677,15 +3341,21 @@ void VideoCapture::resetAutoWhiteBalance()
 }
 
 void VideoCapture::setGamma(int gamma)
+{
+    writeGamma(gamma);
+}
+
+bool VideoCapture::writeGamma(int gamma)
 {
     int current_gamma = getCameraControlSettings(LINUX_CTRL_GAMMA);
 
-    if (gamma!=current_gamma)
-    {
-        setGammaPreset(0,gamma);
-        setGammaPreset(1,gamma);
-        setCameraControlSettings(LINUX_CTRL_GAMMA, gamma);
-    }
+    if (gamma==current_gamma)
+        return true;
+
+    bool ok = (setGammaPreset(0,gamma)==0);
+    ok &= (setGammaPreset(1,gamma)==0);
+    ok &= setCameraControlSettings(LINUX_CTRL_GAMMA, gamma);
+    return ok;
 }
 
 void VideoCapture::resetGamma()
@@ -1705,6 +3375,17 @@ int VideoCapture::setAECAGC(bool active)
     int res = 0;
     res += ll_isp_aecagc_enable(0, active);
     res += ll_isp_aecagc_enable(1, active);
+
+    const std::lock_guard<std::mutex> lock(mControlsMutex);
+    mXuShadow.aec_agc = (res==0)?(active?1:0):-1;
+    if (active || res!=0) {
+        // Gain and exposure are changed by the automatic control
+        for (int side=0; side<2; side++) {
+            mXuShadow.gain[side] = -1;
+            mXuShadow.exposure[side] = -1;
+        }
+    }
+
     return res;
 }
 
@@ -1720,6 +3401,108 @@ void VideoCapture::resetAECAGC()
     setAECAGC(true);
 }
 
+bool VideoCapture::isAECAGCActive()
+{
+    mControlsMutex.lock();
+    int aec_agc = mXuShadow.aec_agc;
+    mControlsMutex.unlock();
+
+    if (aec_agc >= 0)
+        return (aec_agc != 0);
+
+    return getAECAGC();
+}
+
+bool VideoCapture::applyProfile(const CameraProfile& profile)
+{
+    // The gamma presets can be written only when the capture is started
+    if (!mInitialized)
+        return false;
+
+    bool ok = true;
+
+    // ----> Default values
+    const int ctrl_ids[] = {LINUX_CTRL_BRIGHTNESS, LINUX_CTRL_CONTRAST, LINUX_CTRL_HUE, LINUX_CTRL_SATURATION, LINUX_CTRL_SHARPNESS};
+    const int ctrl_vals[] = {profile.brightness, profile.contrast, profile.hue, profile.saturation, profile.sharpness};
+
+    std::vector<std::pair<int,int>> ctrls;
+    mControlsMutex.lock();
+    for (size_t i=0; i<sizeof(ctrl_ids)/sizeof(int); i++)
+        ctrls.push_back(std::make_pair(ctrl_ids[i], (ctrl_vals[i]<0)?findCameraControl(ctrl_ids[i]).def:ctrl_vals[i]));
+    mControlsMutex.unlock();
+
+    int gamma = DEFAULT_GAMMA_NOECT;
+    if (profile.gamma >= 0)
+        gamma = std::max(DEFAULT_MIN_GAMMA, std::min(DEFAULT_MAX_GAMMA, profile.gamma));
+    // <---- Default values
+
+    // ----> Gamma presets, written before the gamma control
+    for (int side=0; side<2; side++) {
+        mControlsMutex.lock();
+        bool changed = (mXuShadow.gamma_preset[side] != gamma);
+        mControlsMutex.unlock();
+
+        if (changed)
+            ok = (setGammaPreset(side, gamma) == 0) && ok;
+    }
+    // <---- Gamma presets, written before the gamma control
+
+    // ----> V4L2 controls
+    ctrls.push_back(std::make_pair(LINUX_CTRL_GAMMA, gamma));
+    ctrls.push_back(std::make_pair(LINUX_CTRL_AWB_AUTO, profile.auto_white_balance?1:0));
+    ok = setCameraControlsBatch(ctrls) && ok;
+
+    // The white balance is accepted only when the automatic white balance is disabled
+    if (!profile.auto_white_balance && profile.white_balance >= 0) {
+        std::vector<std::pair<int,int>> awb(1, std::make_pair(LINUX_CTRL_AWB, profile.white_balance));
+        ok = setCameraControlsBatch(awb) && ok;
+    }
+    // <---- V4L2 controls
+
+    // ----> XU settings
+    mControlsMutex.lock();
+    XuShadow xu = mXuShadow;
+    mControlsMutex.unlock();
+
+    if (xu.aec_agc != (profile.aec_agc?1:0))
+        ok = (setAECAGC(profile.aec_agc) == 0) && ok;
+
+    for (int side=0; side<2; side++) {
+        const CameraRoi& roi = profile.aec_agc_roi[side];
+        if (roi.w==0 || roi.h==0)
+            continue;
+
+        if (!xu.roi_valid[side] || xu.roi[side].x!=roi.x || xu.roi[side].y!=roi.y ||
+                xu.roi[side].w!=roi.w || xu.roi[side].h!=roi.h)
+            ok = setROIforAECAGC(static_cast<CAM_SENS_POS>(side), roi.x, roi.y, roi.w, roi.h) && ok;
+    }
+
+    if (!profile.aec_agc) {
+        for (int side=0; side<2; side++) {
+            if (profile.gain[side] >= 0) {
+                int gain = std::max(DEFAULT_MIN_GAIN, std::min(DEFAULT_MAX_GAIN, profile.gain[side]));
+                if (xu.gain[side] != gain) {
+                    setGain(static_cast<CAM_SENS_POS>(side), gain);
+                    const std::lock_guard<std::mutex> lock(mControlsMutex);
+                    ok = (mXuShadow.gain[side] == gain) && ok;
+                }
+            }
+
+            if (profile.exposure[side] >= 0) {
+                int exposure = std::max(DEFAULT_MIN_EXP, std::min(DEFAULT_MAX_EXP, profile.exposure[side]));
+                if (xu.exposure[side] != exposure) {
+                    setExposure(static_cast<CAM_SENS_POS>(side), exposure);
+                    const std::lock_guard<std::mutex> lock(mControlsMutex);
+                    ok = (mXuShadow.exposure[side] == exposure) && ok;
+                }
+            }
+        }
+    }
+    // <---- XU settings
+
+    return ok;
+}
+
 bool VideoCapture::setROIforAECAGC(CAM_SENS_POS side, uint16_t x, uint16_t y, uint16_t w, uint16_t h)
 {
     if(side!=CAM_SENS_POS::LEFT && side!=CAM_SENS_POS::RIGHT)
@@ -1739,28 +3522,27 @@ bool VideoCapture::setROIforAECAGC(CAM_SENS_POS side, uint16_t x, uint16_t y, ui
         return false;
     }
 
-    int x_start_high = x / 256;
-    int x_start_low = (x - x_start_high * 256);
-    int y_start_high = y / 256;
-    int y_start_low = (y - x_start_high * 256);
-    int w_start_high = w / 256;
-    int w_start_low = (w - x_start_high * 256);
-    int h_start_high = h / 256;
-    int h_start_low = (h - x_start_high * 256);
-
+    // X, Y, W, H: high and low bytes
+    const uint8_t roi[8] = {
+        static_cast<uint8_t>(x / 256), static_cast<uint8_t>(x % 256),
+        static_cast<uint8_t>(y / 256), static_cast<uint8_t>(y % 256),
+        static_cast<uint8_t>(w / 256), static_cast<uint8_t>(w % 256),
+        static_cast<uint8_t>(h / 256), static_cast<uint8_t>(h % 256)
+    };
 
     uint32_t ulAddr = 0x801810C0;
     if (static_cast<int>(side)==1)
         ulAddr= 0x801818C0;
 
-    int r = ll_write_system_register(ulAddr,static_cast<uint8_t>(x_start_high));ulAddr++;usleep(100);
-    r += ll_write_system_register(ulAddr,static_cast<uint8_t>(x_start_low));ulAddr++;usleep(100);
-    r += ll_write_system_register(ulAddr,static_cast<uint8_t>(y_start_high));ulAddr++;usleep(100);
-    r += ll_write_system_register(ulAddr,static_cast<uint8_t>(y_start_low));ulAddr++;usleep(100);
-    r += ll_write_system_register(ulAddr,static_cast<uint8_t>(w_start_high));ulAddr++;usleep(100);
-    r += ll_write_system_register(ulAddr,static_cast<uint8_t>(w_start_low));ulAddr++;usleep(100);
-    r += ll_write_system_register(ulAddr,static_cast<uint8_t>(h_start_high));ulAddr++;usleep(100);
-    r += ll_write_system_register(ulAddr,static_cast<uint8_t>(h_start_low));ulAddr++;usleep(100);
+    int r = ll_write_system_registers(ulAddr, roi, 8);
+
+    const std::lock_guard<std::mutex> lock(mControlsMutex);
+    int idx = static_cast<int>(side);
+    mXuShadow.roi_valid[idx] = (r==0);
+    mXuShadow.roi[idx].x = x;
+    mXuShadow.roi[idx].y = y;
+    mXuShadow.roi[idx].w = w;
+    mXuShadow.roi[idx].h = h;
 
     return (r==0);
 }
@@ -1772,37 +3554,29 @@ bool VideoCapture::resetROIforAECAGC(CAM_SENS_POS side)
 
 bool VideoCapture::getROIforAECAGC(CAM_SENS_POS side, uint16_t &x, uint16_t &y, uint16_t &w, uint16_t &h)
 {
-    uint8_t x_start_high = 0;
-    uint8_t x_start_low = 0;
-    uint8_t y_start_high =0;
-    uint8_t y_start_low = 0;
-    uint8_t w_start_high =0;
-    uint8_t w_start_low = 0;
-    uint8_t h_start_high = 0;
-    uint8_t h_start_low = 0;
+    // X, Y, W, H: high and low bytes
+    uint8_t roi[8] = {0};
     uint32_t ulAddr = 0x801810C0;
     if (static_cast<int>(side)==1)
         ulAddr= 0x801818C0;
-    int r =  ll_read_system_register(ulAddr,&x_start_high);ulAddr++;usleep(100);
-    r +=  ll_read_system_register(ulAddr,&x_start_low);ulAddr++;usleep(100);
-    r +=   ll_read_system_register(ulAddr,&y_start_high);ulAddr++;usleep(100);
-    r +=   ll_read_system_register(ulAddr,&y_start_low);ulAddr++;usleep(100);
-    r +=   ll_read_system_register(ulAddr,&w_start_high);ulAddr++;usleep(100);
-    r +=   ll_read_system_register(ulAddr,&w_start_low);ulAddr++;usleep(100);
-    r +=   ll_read_system_register(ulAddr,&h_start_high);ulAddr++;usleep(100);
-    r +=   ll_read_system_register(ulAddr,&h_start_low);ulAddr++;usleep(100);
-
-    x = x_start_high*256 + x_start_low;
-    y = y_start_high*256 + y_start_low;
-    w = w_start_high*256 + w_start_low;
-    h = h_start_high*256 + h_start_low;
+    int r = ll_read_system_registers(ulAddr, roi, 8);
+
+    x = roi[0]*256 + roi[1];
+    y = roi[2]*256 + roi[3];
+    w = roi[4]*256 + roi[5];
+    h = roi[6]*256 + roi[7];
 
     return (r==0);
 }
 
 void VideoCapture::setGain(CAM_SENS_POS cam, int gain)
 {
-    if(getAECAGC())
+    writeGain(cam, gain);
+}
+
+bool VideoCapture::writeGain(CAM_SENS_POS cam, int gain)
+{
+    if(isAECAGCActive())
         setAECAGC(false);
 
     if (gain <= DEFAULT_MIN_GAIN)
@@ -1818,8 +3592,12 @@ void VideoCapture::setGain(CAM_SENS_POS cam, int gain)
 
     ucGainM = (rawGain >> 8) & 0xff;
     ucGainL = rawGain & 0xff;
-    ll_isp_set_gain(ucGainH, ucGainM, ucGainL, sensorId);
+    int r = ll_isp_set_gain(ucGainH, ucGainM, ucGainL, sensorId);
+
+    const std::lock_guard<std::mutex> lock(mControlsMutex);
+    mXuShadow.gain[sensorId] = (r==0)?gain:-1;
 
+    return (r==0);
 }
 
 int VideoCapture::getGain(CAM_SENS_POS cam)
@@ -1839,10 +3617,15 @@ int VideoCapture::getGain(CAM_SENS_POS cam)
 }
 
 void VideoCapture::setExposure(CAM_SENS_POS cam, int exposure)
+{
+    writeExposure(cam, exposure);
+}
+
+bool VideoCapture::writeExposure(CAM_SENS_POS cam, int exposure)
 {
     unsigned char ucExpH, ucExpM, ucExpL;
 
-    if(getAECAGC())
+    if(isAECAGCActive())
         setAECAGC(false);
 
     if(exposure < DEFAULT_MIN_EXP)
@@ -1861,7 +3644,12 @@ void VideoCapture::setExposure(CAM_SENS_POS cam, int exposure)
     ucExpH = (rawExp >> 12) & 0xff;
     ucExpM = (rawExp >> 4) & 0xff;
     ucExpL = (rawExp << 4) & 0xf0;
-    ll_isp_set_exposure(ucExpH, ucExpM, ucExpL, sensorId);
+    int r = ll_isp_set_exposure(ucExpH, ucExpM, ucExpL, sensorId);
+
+    const std::lock_guard<std::mutex> lock(mControlsMutex);
+    mXuShadow.exposure[sensorId] = (r==0)?exposure:-1;
+
+    return (r==0);
 }
 
 int VideoCapture::getExposure(CAM_SENS_POS cam)
@@ -1884,6 +3672,107 @@ int VideoCapture::getExposure(CAM_SENS_POS cam)
     return exposure;
 }
 
+std::future<bool> VideoCapture::enqueueControl(uint32_t key, std::function<bool()> command)
+{
+    const std::lock_guard<std::mutex> lock(mControlQueueMutex);
+
+    if( !mControlQueueOpen )
+    {
+        std::promise<bool> promise;
+        promise.set_value(false);
+        return promise.get_future();
+    }
+
+    if( !mControlQueue )
+    {
+        mControlQueue = std::make_shared<ControlQueue>();
+        mControlQueue->thread = std::thread(&ControlQueue::work, mControlQueue.get());
+    }
+
+    return mControlQueue->push(key, std::move(command));
+}
+
+void VideoCapture::stopControlQueue()
+{
+    std::shared_ptr<ControlQueue> queue;
+
+    // No new command can create a queue while the camera is closed
+    mControlQueueMutex.lock();
+    mControlQueueOpen = false;
+    queue.swap(mControlQueue);
+    mControlQueueMutex.unlock();
+
+    if( queue )
+        queue->shutdown();
+}
+
+std::future<bool> VideoCapture::setLEDstatusAsync(bool status)
+{
+    return enqueueControl(controlKey(CTRL_KEY_LED), [this,status]{return setLEDstatus(status)==0;});
+}
+
+std::future<bool> VideoCapture::setBrightnessAsync(int brightness)
+{
+    return enqueueControl(controlKey(CTRL_KEY_BRIGHTNESS), [this,brightness]{return setCameraControlSettings(LINUX_CTRL_BRIGHTNESS, brightness);});
+}
+
+std::future<bool> VideoCapture::setSharpnessAsync(int sharpness)
+{
+    return enqueueControl(controlKey(CTRL_KEY_SHARPNESS), [this,sharpness]{return setCameraControlSettings(LINUX_CTRL_SHARPNESS, sharpness);});
+}
+
+std::future<bool> VideoCapture::setContrastAsync(int contrast)
+{
+    return enqueueControl(controlKey(CTRL_KEY_CONTRAST), [this,contrast]{return setCameraControlSettings(LINUX_CTRL_CONTRAST, contrast);});
+}
+
+std::future<bool> VideoCapture::setHueAsync(int hue)
+{
+    return enqueueControl(controlKey(CTRL_KEY_HUE), [this,hue]{return setCameraControlSettings(LINUX_CTRL_HUE, hue);});
+}
+
+std::future<bool> VideoCapture::setSaturationAsync(int saturation)
+{
+    return enqueueControl(controlKey(CTRL_KEY_SATURATION), [this,saturation]{return setCameraControlSettings(LINUX_CTRL_SATURATION, saturation);});
+}
+
+std::future<bool> VideoCapture::setWhiteBalanceAsync(int wb)
+{
+    return enqueueControl(controlKey(CTRL_KEY_WHITE_BALANCE), [this,wb]{return writeWhiteBalance(wb);});
+}
+
+std::future<bool> VideoCapture::setAutoWhiteBalanceAsync(bool active)
+{
+    return enqueueControl(controlKey(CTRL_KEY_WHITE_BALANCE), [this,active]{return setCameraControlSettings(LINUX_CTRL_AWB_AUTO, active?1:0);});
+}
+
+std::future<bool> VideoCapture::setGammaAsync(int gamma)
+{
+    return enqueueControl(controlKey(CTRL_KEY_GAMMA), [this,gamma]{return writeGamma(gamma);});
+}
+
+std::future<bool> VideoCapture::setAECAGCAsync(bool active)
+{
+    return enqueueControl(controlKey(CTRL_KEY_AECAGC), [this,active]{return setAECAGC(active)==0;});
+}
+
+std::future<bool> VideoCapture::setROIforAECAGCAsync(CAM_SENS_POS side, uint16_t x, uint16_t y, uint16_t w, uint16_t h)
+{
+    return enqueueControl(controlKey(CTRL_KEY_ROI, static_cast<int>(side)), [this,side,x,y,w,h]{
+        return setROIforAECAGC(side, x, y, w, h);
+    });
+}
+
+std::future<bool> VideoCapture::setGainAsync(CAM_SENS_POS cam, int gain)
+{
+    return enqueueControl(controlKey(CTRL_KEY_GAIN, static_cast<int>(cam)), [this,cam,gain]{return writeGain(cam, gain);});
+}
+
+std::future<bool> VideoCapture::setExposureAsync(CAM_SENS_POS cam, int exposure)
+{
+    return enqueueControl(controlKey(CTRL_KEY_EXPOSURE, static_cast<int>(cam)), [this,cam,exposure]{return writeExposure(cam, exposure);});
+}
+
 int VideoCapture::calcRawGainValue(int gain) {
 
     // From [0,100] to segmented gain
@@ -1938,76 +3827,54 @@ int VideoCapture::calcGainValue(int rawGain)
 #ifdef SENSOR_LOG_AVAILABLE
 bool VideoCapture::enableAecAgcSensLogging(bool enable, int frame_skip/*=10*/)
 {
-    if(!enable)
+    // ----> Stop the logging thread
+    mLogEnable=false;
+    if(mLogThread.joinable())
     {
-        mLogEnable=false;
-        if(mLogFileLeft.is_open())
-        {
-            mLogFileLeft.close();
-        }
-        if(mLogFileRight.is_open())
-        {
-            mLogFileRight.close();
-        }
-        return true;
-    }
+        mLogMutex.lock();
+        mLogStop = true;
+        mLogMutex.unlock();
+        mLogCv.notify_one();
 
-    mLogFrameSkip = frame_skip;
-
-    mLogFilenameLeft = getCurrentDateTime(DATE);
-    mLogFilenameLeft += "_";
-    mLogFilenameLeft += getCurrentDateTime(TIME);
-    mLogFilenameLeft += "_agc_aec_registers-LEFT.csv";
-
-    mLogFilenameRight = getCurrentDateTime(DATE);
-    mLogFilenameRight += "_";
-    mLogFilenameRight += getCurrentDateTime(TIME);
-    mLogFilenameRight += "_agc_aec_registers-RIGHT.csv";
-
-    mLogFileLeft.open(mLogFilenameLeft, std::ofstream::out );
-    mLogFileRight.open(mLogFilenameRight, std::ofstream::out );
-
-    if(mLogFileLeft.bad())
+        mLogThread.join();
+    }
+    if(mLogFile.is_open())
     {
-        std::cerr << "Logging not started. Error creating the log file: '" << mLogFilenameLeft << "'" << std::endl;
-        mLogEnable = false;
-        return false;
+        mLogFile.close();
     }
+    // <---- Stop the logging thread
 
-    if(mLogFileRight.bad())
+    if(!enable)
     {
-        std::cerr << "Logging not started. Error creating the log file: '" << mLogFilenameRight << "'" << std::endl;
-        mLogEnable = false;
-        mLogFileLeft.close();
-        return false;
+        return true;
     }
 
-    mLogFileLeft << "TIMESTAMP" << LOG_SEP;
-    mLogFileLeft << "OV580-ISP_EN_HIGH" << LOG_SEP;
-    mLogFileLeft << "OV580-yavg_low" << LOG_SEP;
-    mLogFileLeft << "OV580-yavg_high" << LOG_SEP;
-    mLogFileLeft << "OV580-interrupt_ctrl1";
+    mLogFrameSkip = std::max(1,frame_skip);
 
-    mLogFileRight << "TIMESTAMP" << LOG_SEP;
-    mLogFileRight << "OV580-ISP_EN_HIGH" << LOG_SEP;
-    mLogFileRight << "OV580-yavg_low" << LOG_SEP;
-    mLogFileRight << "OV580-yavg_high" << LOG_SEP;
-    mLogFileRight << "OV580-interrupt_ctrl1";
+    mLogFilename = getCurrentDateTime(DATE);
+    mLogFilename += "_";
+    mLogFilename += getCurrentDateTime(TIME);
+    mLogFilename += "_agc_aec_registers.bin";
 
-    for (int addr = 0x00; addr <= 0x22; ++addr)
-    {
-        mLogFileLeft << LOG_SEP << "OV580-YAVG[0x" << std::hex << std::setfill('0') << std::setw(2) << addr << "]";
-        mLogFileRight << LOG_SEP << "OV580-YAVG[0x" << std::hex << std::setfill('0') << std::setw(2) << addr << "]";
-    }
+    mLogFile.open(mLogFilename, std::ofstream::out | std::ofstream::binary );
 
-    for (int addr = 0x3500; addr <= 0x3515; ++addr)
+    if(!mLogFile.is_open())
     {
-        mLogFileLeft << LOG_SEP << "OV4689-GAIN_EXP[0x" << std::hex << std::setfill('0') << std::setw(4) << addr << "]";
-        mLogFileRight << LOG_SEP << "OV4689-GAIN_EXP[0x" << std::hex << std::setfill('0') << std::setw(4) << addr << "]";
+        std::cerr << "Logging not started. Error creating the log file: '" << mLogFilename << "'" << std::endl;
+        return false;
     }
 
-    mLogFileLeft << std::endl;
-    mLogFileRight << std::endl;
+    AecAgcLogHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, AEC_AGC_LOG_MAGIC, sizeof(header.magic));
+    header.version = AEC_AGC_LOG_VERSION;
+    header.reg_count = AEC_AGC_LOG_REG_COUNT;
+    mLogFile.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    mLogPendingTs = 0;
+    mLogSkipped = 0;
+    mLogStop = false;
+    mLogThread = std::thread(&VideoCapture::logThreadFunc, this);
 
     mLogEnable = true;
     return true;
@@ -2027,114 +3894,201 @@ void VideoCapture::setColorBars(int side, bool c)
 }
 
 
-void VideoCapture::saveAllISPRegisters(std::string filename)
+int VideoCapture::readRegisterBlock(RegisterBlock& block)
 {
-    std::ofstream logFile;
-    logFile.open(filename,std::ofstream::out);
-    int res = 0;
-    unsigned long long ulAddrL =  0x80181000;
-    unsigned long long   ulAddrR =  0x80181800;
+    int count = static_cast<int>(block.values.size());
+    int chunk = ll_burstPayloadSize();
+    int failures = 0;
 
-    for (int p = 0;p<0x800;p++)
+    for (int offset = 0; offset < count; offset += chunk)
     {
-        uint8_t valL,valR;
-        res += ll_read_system_register( ulAddrL+p, &valL);
-        res += ll_read_system_register( ulAddrR+p, &valR);
+        int n = std::min(chunk, count-offset);
+        uint64_t addr = block.address+offset;
+        uint8_t* values = block.values.data()+offset;
+
+        int res = 0;
+        if (block.bank == REG_BANK::ISP)
+            res = ll_read_system_registers(addr, values, n);
+        else
+            res = ll_read_sensor_registers(block.side, 1, addr, values, n);
+
+        if (res == 0)
+        {
+            std::fill(block.valid.begin()+offset, block.valid.begin()+offset+n, 1);
+            continue;
+        }
+
+        // ----> A register of the range cannot be read: read them one by one
+        for (int i = 0; i < n; i++)
+        {
+            if (block.bank == REG_BANK::ISP)
+                res = ll_read_system_register(addr+i, &values[i]);
+            else
+                res = ll_read_sensor_register(block.side, 1, addr+i, &values[i]);
 
-        logFile <<"0x" << std::hex << std::setfill('0') << std::setw(8) << static_cast<unsigned long long>(ulAddrL+p)<<" , "<<std::hex << std::setfill('0') << std::setw(2) << static_cast<unsigned long long>(valL)<<" , "<<std::hex << std::setfill('0') << std::setw(2) << static_cast<unsigned long long>(valR)<<std::endl;
-        usleep(10);
+            block.valid[offset+i] = (res == 0)?1:0;
+            if (res != 0)
+            {
+                values[i] = 0;
+                failures++;
+            }
+        }
+        // <---- A register of the range cannot be read: read them one by one
     }
 
-    logFile.close();
+    return failures;
 }
 
-void VideoCapture::saveAllSensorsRegisters(std::string filename)
+int VideoCapture::dumpRegisters(RegisterSnapshot& snapshot)
 {
-    std::ofstream logFile;
-    logFile.open(filename,std::ofstream::out);
+    snapshot = RegisterSnapshot();
+    snapshot.timestamp = getWallTimestamp();
+    snapshot.serial_number = mIdentity.serial_number;
 
-    int res = 0;
-    for (int addr = 0x3000; addr <= 0x6000; ++addr)
+    for (int side = 0; side < 2; side++)
     {
-        uint8_t valL,valR;
-        res += ll_read_sensor_register( 0, 1, addr, &valL);
-        res += ll_read_sensor_register( 1, 1, addr, &valR);
-
-        usleep(10);
-        logFile <<"0x" << std::hex << std::setfill('0') << std::setw(8) << static_cast<int>(addr)<<" , "<<std::hex << std::setfill('0') << std::setw(2) << static_cast<unsigned long long>(valL)<<" , "<<std::hex << std::setfill('0') << std::setw(2) << static_cast<unsigned long long>(valR)<<std::endl;
+        snapshot.blocks.push_back(makeRegisterBlock(REG_BANK::ISP, static_cast<uint8_t>(side),
+                                                    (side==0)?REG_DUMP_ISP_ADDR_LEFT:REG_DUMP_ISP_ADDR_RIGHT, REG_DUMP_ISP_COUNT));
+        snapshot.blocks.push_back(makeRegisterBlock(REG_BANK::SENSOR, static_cast<uint8_t>(side),
+                                                    REG_DUMP_SENS_ADDR, REG_DUMP_SENS_COUNT));
     }
 
-    logFile.close();
+    int failures = 0;
+    for (RegisterBlock& block : snapshot.blocks)
+        failures += readRegisterBlock(block);
+
+    return failures;
 }
 
-void VideoCapture::saveLogDataLeft()
+void VideoCapture::saveAllISPRegisters(std::string filename)
 {
-    const int reg_count = 61;
-    uint8_t values[reg_count];
-    int idx = 0;
-
-    int res = 0;
-    res += ll_read_system_register( 0x80181002, &values[idx++]);
-    res += ll_read_system_register( 0x80181031, &values[idx++]);
-    res += ll_read_system_register( 0x80181032, &values[idx++]);
-    res += ll_read_system_register( 0x80181033, &values[idx++]);
+    RegisterBlock blocks[2];
+    for (int side = 0; side < 2; side++)
+    {
+        blocks[side] = makeRegisterBlock(REG_BANK::ISP, static_cast<uint8_t>(side),
+                                         (side==0)?REG_DUMP_ISP_ADDR_LEFT:REG_DUMP_ISP_ADDR_RIGHT, REG_DUMP_ISP_COUNT);
+        readRegisterBlock(blocks[side]);
+    }
 
-    for(int reg_addr = 0x00; reg_addr <= 0x22; ++reg_addr)
+    // The whole file is formatted in memory and written at once
+    std::string content;
+    content.reserve(REG_DUMP_ISP_COUNT*24);
+    char line[64];
+    for (int p = 0; p < REG_DUMP_ISP_COUNT; p++)
     {
-        uint64_t addr = 0x801810C0+reg_addr;
-        res += ll_read_system_register( addr, &values[idx++]);
+        snprintf(line, sizeof(line), "0x%08llx , %02x , %02x\n", static_cast<unsigned long long>(REG_DUMP_ISP_ADDR_LEFT+p),
+                 blocks[0].values[p], blocks[1].values[p]);
+        content += line;
     }
 
-    for (int addr = 0x3500; addr <= 0x3515; ++addr)
+    std::ofstream logFile;
+    logFile.open(filename,std::ofstream::out);
+    logFile << content;
+    logFile.close();
+}
+
+void VideoCapture::saveAllSensorsRegisters(std::string filename)
+{
+    RegisterBlock blocks[2];
+    for (int side = 0; side < 2; side++)
     {
-        res += ll_read_sensor_register( 0, 1, addr, &values[idx++]);
+        blocks[side] = makeRegisterBlock(REG_BANK::SENSOR, static_cast<uint8_t>(side), REG_DUMP_SENS_ADDR, REG_DUMP_SENS_COUNT);
+        readRegisterBlock(blocks[side]);
     }
 
-    mLogFileLeft << std::dec << mLastFrame.timestamp << LOG_SEP;
-    for(int i=0; i<reg_count; i++)
+    // The whole file is formatted in memory and written at once
+    std::string content;
+    content.reserve(REG_DUMP_SENS_COUNT*24);
+    char line[64];
+    for (int p = 0; p < REG_DUMP_SENS_COUNT; p++)
     {
-        mLogFileLeft << "0x" << std::hex << std::setfill('0') << std::setw(2) << static_cast<int>(values[i]);
-        if(i==(reg_count-1))
-            mLogFileLeft << std::endl;
-        else
-            mLogFileLeft << LOG_SEP;
+        snprintf(line, sizeof(line), "0x%08x , %02x , %02x\n", REG_DUMP_SENS_ADDR+p,
+                 blocks[0].values[p], blocks[1].values[p]);
+        content += line;
     }
+
+    std::ofstream logFile;
+    logFile.open(filename,std::ofstream::out);
+    logFile << content;
+    logFile.close();
 }
 
-void VideoCapture::saveLogDataRight()
+void VideoCapture::requestLogSample(uint64_t frame_ts)
 {
-    const int reg_count = 61;
-    uint8_t values[reg_count];
-    int idx = 0;
+    mLogMutex.lock();
+    if(mLogPendingTs!=0)
+        mLogSkipped++;
+    mLogPendingTs = frame_ts;
+    mLogMutex.unlock();
 
-    int res = 0;
-    res += ll_read_system_register( 0x80181802, &values[idx++]);
-    res += ll_read_system_register( 0x80181831, &values[idx++]);
-    res += ll_read_system_register( 0x80181832, &values[idx++]);
-    res += ll_read_system_register( 0x80181833, &values[idx++]);
+    mLogCv.notify_one();
+}
+
+void VideoCapture::logThreadFunc()
+{
+    // ----> Low priority thread
+    ThreadConfig cfg;
+    cfg.name = "zed_oc_reg_log";
+    std::string err;
+    applyThreadConfig(cfg, err);
 
-    for(int reg_addr = 0x00; reg_addr <= 0x22; ++reg_addr)
+    if(setpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)), 19)!=0)
     {
-        uint64_t addr = 0x801818C0+reg_addr;
-        res += ll_read_system_register( addr, &values[idx++]);
+        std::string msg = std::string("Cannot lower the priority of the registers logging thread: ") + strerror(errno);
+        WARNING_OUT(mParams.verbose,msg);
     }
+    // <---- Low priority thread
 
-    for (int addr = 0x3500; addr <= 0x3515; ++addr)
+    std::unique_lock<std::mutex> lock(mLogMutex);
+    while(!mLogStop)
     {
-        res += ll_read_sensor_register( 1, 1, addr, &values[idx++]);
+        mLogCv.wait(lock, [this]{return mLogStop || mLogPendingTs!=0;});
+        if(mLogStop)
+            break;
+
+        uint64_t frame_ts = mLogPendingTs;
+        mLogPendingTs = 0;
+        lock.unlock();
+
+        AecAgcLogSample samples[2];
+        for(int side=0; side<2; side++)
+        {
+            memset(&samples[side], 0, sizeof(AecAgcLogSample));
+            samples[side].frame_ts = frame_ts;
+            samples[side].side = static_cast<uint8_t>(side);
+            samples[side].result = readLogSample(side, samples[side]);
+            samples[side].sample_ts = getSteadyTimestamp();
+        }
+        mLogFile.write(reinterpret_cast<const char*>(samples), sizeof(samples));
+
+        lock.lock();
     }
+    lock.unlock();
+
+    mLogFile.flush();
 
-    mLogFileRight << std::dec << mLastFrame.timestamp << LOG_SEP;
-    for(int i=0; i<reg_count; i++)
+    if(mLogSkipped>0)
     {
-        mLogFileRight << "0x" << std::hex << std::setfill('0') << std::setw(2) << static_cast<int>(values[i]);
-        if(i==(reg_count-1))
-            mLogFileRight << std::endl;
-        else
-            mLogFileRight << LOG_SEP;
+        std::string msg = std::string("AEC/AGC registers samples skipped while the previous sample was being read: ") + std::to_string(mLogSkipped);
+        WARNING_OUT(mParams.verbose,msg);
     }
 }
 
+int VideoCapture::readLogSample(int side, AecAgcLogSample& sample)
+{
+    uint64_t isp_addr = (side==0)?0x80181000:0x80181800;
+    uint8_t* values = sample.values;
+
+    // Contiguous registers are read with a single burst command
+    int res = 0;
+    res += ll_read_system_registers( isp_addr+0x02, values, 1);
+    res += ll_read_system_registers( isp_addr+0x31, values+1, 3);
+    res += ll_read_system_registers( isp_addr+0xC0, values+4, 0x23);
+    res += ll_read_sensor_registers( side, 1, 0x3500, values+4+0x23, 0x16);
+
+    return res;
+}
+
 bool VideoCapture::resetAGCAECregisters() {
     int res = 0;
 